@@ -1,37 +1,43 @@
 #include "CoolDB.h"
-
+#include "Executor/Aggregate.h"
+#include "Executor/Sort.h"
+#include "Parser/Parser.h"
+#include "Storage/BinaryFormat.h"
+#include "Storage/CsvLoader.h"
+#include "Table/ThreadPool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
 #include <fstream>
-#include <list>
-
-// Query regexps
-const std::regex kCreateReg(R"(\s*CREATE\s+TABLE\s+\w+\s+\((\s*\w+\s+(int|float|double|bool|varchar(\([0-9]+\))?)\s*,)+\s*PRIMARY\s+KEY\s*\((\s*\w+,?)+\)\s*\);)");
-const std::regex kInsertReg(R"(\s*INSERT\s+INTO\s+\w+\s+(\(\s*(\w+,\s*)*\w+\s*\))?\s*VALUES\s*(\(\s*((\d+\.?\d*,\s*)|('[^']*',\s*))*((\s*\d+\.?\d*\s*)|('[^']*'\s*))\s*\),\s*)*(\(\s*((\d+\.?\d*,\s*)|('[^']*',\s*))*((\s*\d+\.?\d*\s*)|('[^']*'\s*))\s*\)\s*);)");
-const std::regex kDropReg(R"(\s*DROP\s+TABLE\s+\w+;)");
-const std::regex kUpdateReg(R"(\s*UPDATE\s+\w+\s+SET\s+\w+\s+=\s+(\w+|'[^']+')(\s+WHERE\s+((NOT)?\s*(\w+\s*(=|!=|>|<|>=|<=){1}\s*([\d\.]+|'[^']+'))\s+(OR|AND){1}\s+)*((NOT)?\s*\w+\s*(=|!=|>|<|>=|<=){1}\s*([\d\.]+|'[^']+')))?;)");
-const std::regex kDeleteReg(R"(\s*DELETE\s+FROM\s+\w+\s*(\s*WHERE\s+((NOT)?\s*(\w+\s*(=|!=|>|<|>=|<=){1}\s*([\d\.]+|'[^']+'))\s+(OR|AND){1}\s+)*((NOT)?\s*\w+\s*(=|!=|>|<|>=|<=){1}\s*([\d\.]+|'[^']+')))?;)");
-const std::regex kSelectReg(R"(\s*SELECT\s+(\*|(\w+,\s*)*(\w+))\s+FROM\s+\w+\s*(\s+(INNER\s+|LEFT\s+|RIGHT\s+)?JOIN\s+\w+\s+ON\s+[\w\.]+\s+=\s+[\w\.]+\s*)?(\s+WHERE\s+((NOT)?\s*(\w+\s*(=|!=|>|<|>=|<=){1}\s*([\d\.]+|'[^']+'))\s+(OR|AND){1}\s+)*((NOT)?\s*\w+\s*(=|!=|>|<|>=|<=){1}\s*([\d\.]+|'[^']+')))?;)");
-
-// tokenization regexps
-const std::regex kSplit(R"(([\w]+)[\s,\(\)]*)");
-const std::regex kSplitNumbers(R"(([\w\.]+)[\s,\(\)]*)");
-const std::regex kSplitOperations(R"(([\w\.=!><\*]+)[\s,\(\)]*)");
-
-// database commands
-const std::string kCloseCommand = "@close";
-const std::string kInfoCommand = "@info";
-const std::regex kSaveCommand(R"(\s*@save\s+\w+\.[a-zA-z]+\s*)");
-const std::regex kLoadCommand(R"(\s*@load\s+\w+\.[a-zA-z]+\s*)");
-
-// .................DESTRUCTOR
-
-CoolDB::~CoolDB() {
-    for (Table* table : table_list_)
-        delete table;
-}
+#include <numeric>
+#include <sstream>
+
+// the log is folded into a new snapshot once it grows past this
+const size_t kCheckpointBytes = size_t{64} << 20;
+// SELECTs kept by their normalized text, the cache is emptied once it holds this many
+const size_t kMaxStatements = 1024;
 
 // .................FILES
 
-void CoolDB::load_from_file(const std::string& path) {
+void CoolDB::load_from_file(const std::string& path, std::ostream& out) {
+    MappedFile file(path);
+    if (!is_binary_file(file)) {
+        load_from_text_file(path, out);
+        return;
+    }
+    for (Table* table : read_binary(file))
+        add_loaded_table(std::unique_ptr<Table>(table), out);
+}
+
+void CoolDB::add_loaded_table(std::unique_ptr<Table> table, std::ostream& out) {
+    const std::string name = table->name();
+    if (!catalog_.insert(std::move(table)))
+        out << "@Cant load table " << name << ", already there's table with this name" << std::endl;
+}
+
+// text format written by older versions, whitespace separated
+void CoolDB::load_from_text_file(const std::string& path, std::ostream& out) {
     std::ifstream file(path);
     if (!file.is_open())
         throw std::runtime_error{"Can't open the file"};
@@ -41,7 +47,7 @@ void CoolDB::load_from_file(const std::string& path) {
         std::string name;
         size_t number_of_columns;
         file >> name;
-        auto table = new Table(name);
+        auto table = std::make_unique<Table>(name);
 
         file >> number_of_columns;
         for (size_t j = 0; j < number_of_columns; ++j) {
@@ -89,402 +95,841 @@ void CoolDB::load_from_file(const std::string& path) {
                 else
                     ins.push_back(Null());
             }
-            table->insert_row(ins);
+            table->insert_row(std::move(ins));
         }
-        table_list_.push_back(table);
+        add_loaded_table(std::move(table), out);
     }
     file.close();
 }
 
 void CoolDB::save_to_file(const std::string& path) {
-    std::ofstream file(path);
-    if (!file.is_open())
-        throw std::runtime_error{"Can't open the file"};
+    std::vector<Catalog::ReadHandle> handles = catalog_.read_all();
+    std::vector<const Table*> tables;
+    for (const Catalog::ReadHandle& handle : handles)
+        tables.push_back(handle.get());
+    write_binary(path, tables);
+}
 
-    file << table_list_.size() << '\n';
-    for (const auto& table : table_list_) {
-        size_t number_of_columns = table->size().first;
-        size_t number_of_rows = table->size().second;
-        file << table->name() << '\n' << table->size().first << '\n';
-
-        for (size_t i = 0; i < number_of_columns; ++i) {
-            switch (table->get_types()[i]) {
-                case kTypeId::INT:
-                    file << "int ";
-                    break;
-                case kTypeId::FLOAT:
-                    file << "float ";
-                    break;
-                case kTypeId::DOUBLE:
-                    file << "double ";
-                    break;
-                case kTypeId::BOOL:
-                    file << "bool ";
-                    break;
-                case kTypeId::STRING:
-                    file << "varchar ";
-                    break;
-                case kTypeId::NULLOBJ:
-                    file << "null ";
-                    break;
-            }
-            file << table->get_names()[i] << '\n';
-        }
-        file << table->get_primary_keys().size();
-        for (size_t x : table->get_primary_keys())
-            file << ' ' << x;
-        file << '\n';
-        file << number_of_rows << '\n';
-        for (const auto& row : table->get_rows()) {
-            for (int i = 0; i < table->size().first; ++i) {
-                try {
-                    file << std::get<int>(row[i]) << ' ';
-                } catch (const std::bad_variant_access& e) {
-                    try {
-                        file << std::get<double>(row[i]) << ' ';
-                    } catch (const std::bad_variant_access& e) {
-                        try {
-                            file << std::get<float>(row[i]) << ' ';
-                        } catch (const std::bad_variant_access& e) {
-                            try {
-                                file << std::get<bool>(row[i]) << ' ';
-                            } catch (const std::bad_variant_access& e) {
-                                try {
-                                    file << std::get<Null>(row[i]) << ' ';
-                                } catch (const std::bad_variant_access& e) {
-                                    file << '\'' << std::get<std::string>(row[i]) << '\'' << ' ';
-                                }
-                            }
-                        }
-                    }
-                }
+// ............DURABILITY
+
+void CoolDB::open_database(std::string_view name, std::chrono::milliseconds flush_interval, std::ostream& out) {
+    if (wal_ != nullptr) {
+        out << "@Database is already open" << std::endl;
+        return;
+    }
+    const std::string database = "../Data/" + std::string(name);
+    uint32_t snapshot_checkpoint = 0;
+    if (std::filesystem::exists(database + ".db")) {
+        MappedFile file(database + ".db");
+        if (!is_binary_file(file))
+            throw std::runtime_error{"Wrong snapshot file"};
+        snapshot_checkpoint = read_checkpoint(file);
+        for (Table* table : read_binary(file))
+            add_loaded_table(std::unique_ptr<Table>(table), out);
+    }
+
+    // statements of the log are applied again, then folded into a new snapshot. Every one of them was applied
+    // when it was logged, so one that fails now loses data and is reported with its errors
+    auto log = std::make_unique<WriteAheadLog>(database + ".wal", snapshot_checkpoint, flush_interval);
+    for (const std::string& record : log->take_recovered()) {
+        std::ostringstream errors;
+        bool replayed = false;
+        try {
+            if (!Transaction::is_record(record)) {
+                replayed = apply(Parser(record).parse(), record, errors).has_value();
+            } else {
+                // a statement the transaction doesn't take prints its error, the others aren't committed then
+                Transaction transaction;
+                for (const std::string& statement : Transaction::statements(record))
+                    add_to_transaction(Parser(statement).parse(), statement, transaction, errors);
+                replayed = errors.view().empty() && !transaction.empty() && commit(transaction, errors).has_value();
             }
-            file << '\n';
+        } catch (const std::runtime_error& e) {
+            errors << '@' << e.what() << '\n';
+        }
+        if (!replayed) {
+            if (Transaction::is_record(record))
+                out << "@Can't replay a logged transaction\n";
+            else
+                out << "@Can't replay a logged statement: " << record << '\n';
+            out << errors.view() << std::flush;
         }
     }
+
+    database_ = database;
+    wal_ = std::move(log);
+    checkpoint();
+}
+
+void CoolDB::checkpoint() {
+    const uint32_t next = wal_->checkpoint() + 1;
+    const std::string snapshot = database_ + ".db";
+    std::vector<Catalog::ReadHandle> handles = catalog_.read_all();
+    std::vector<const Table*> tables;
+    for (const Catalog::ReadHandle& handle : handles)
+        tables.push_back(handle.get());
+    write_binary(snapshot + ".tmp", tables, next);
+    sync_file(snapshot + ".tmp");
+    replace_file(snapshot + ".tmp", snapshot);
+    // a crash before the reset leaves a log of the old checkpoint, which open ignores
+    wal_->reset(next);
 }
 
 // ............OTHER
 
-Table* CoolDB::find_table(const std::string& name) {
-    Table* ret = nullptr;
-    for (Table* table : table_list_) {
-        if (table->name() == name) {
-            ret = table;
-            break;
-        }
+std::vector<std::forward_list<Condition>> CoolDB::generate_check_list(const WhereClause& where,
+                                                                     const TableView& table,
+                                                                     std::ostream& out) const {
+    return bind_where(plan_where(where, table, nullptr), {}, out);
+}
+
+// ............QUERIES
+
+bool CoolDB::create_query(const CreateQuery& query, std::ostream& out) {
+    auto new_table = std::make_unique<Table>(std::string(query.table_));
+    for (const ColumnDefinition& column : query.columns_)
+        new_table->add_column(std::string(column.type_), std::string(column.name_), column.length_);
+    for (std::string_view key : query.primary_key_)
+        new_table->add_primary_index(std::string(key));
+    if (!catalog_.insert(std::move(new_table))) {
+        out << "@Cant create table, already there's table with this name" << std::endl;
+        return false;
     }
+    return true;
+}
 
-    return ret;
+bool CoolDB::create_index_query(const CreateIndexQuery& query, Table* table, std::ostream& out) {
+    size_t column_index = table->get_index_by_name(query.column_);
+    if (column_index == static_cast<size_t>(-1)) {
+        out << "@Column " << query.column_ << " not found" << std::endl;
+        return false;
+    }
+    try {
+        table->add_index(std::string(query.name_), column_index);
+    } catch (const std::runtime_error& e) {
+        out << '@' << e.what() << std::endl;
+        return false;
+    }
+    return true;
 }
 
-std::vector<std::string> CoolDB::tokenize(const std::string& line, const std::regex& reg) {
-    return std::vector<std::string>{std::sregex_token_iterator(std::cbegin(line), std::cend(line), reg, 1),
-                                    std::sregex_token_iterator()};
+bool CoolDB::insert_query(const InsertQuery& query, Table* table, std::ostream& out) {
+    std::vector<Column> rows;
+    if (!typed_rows(query, table, rows, out))
+        return false;
+    // a repeated key or a too long string anywhere keeps every row out
+    try {
+        table->append_columns(std::move(rows));
+    } catch (const std::runtime_error& e) {
+        out << e.what() << std::endl;
+        return false;
+    }
+    return true;
 }
 
-std::vector<std::forward_list<Condition>> CoolDB::generate_check_list(const std::vector<std::string>& tokens,
-                                                                      size_t start_index, Table* table) const {
-    std::vector<std::forward_list<Condition>> check_list(1);
-    const std::vector<kTypeId>& column_types = table->get_types();
-    size_t& i = start_index;
-    for (; i + 2 < tokens.size(); i += 3) {
-        Condition cond;
-        if (tokens[i] == "NOT") {
-            cond.not_ = true;
-            ++i;
-        }
-        size_t ind = table->get_index_by_name(tokens[i]);
-        cond.column_ = ind;
-        cond.op_ = kOperationsID[tokens[i + 1]];
-        try {
-            cond.data_ = string_to_tablevar(tokens[i + 2], column_types[ind]);
-        } catch (const std::exception& e) {
-            std::cout << e.what() << std::endl;
-            return std::vector<std::forward_list<Condition>>{};
-        }
-        check_list[check_list.size() - 1].push_front(cond);
-        if (i + 3 < tokens.size()) {
-            if (tokens[i + 3] == "OR")
-                check_list.resize(check_list.size() + 1);
-            ++i;
-        }
+bool CoolDB::drop_query(const DropQuery& query, std::ostream& out) {
+    if (!catalog_.erase(query.table_)) {
+        out << "@Table " << query.table_ << " not found\n";
+        return false;
     }
-    return check_list;
+    return true;
 }
 
-// ............QUERIES
+bool CoolDB::update_query(const UpdateQuery& query, Table* table, std::ostream& out) {
+    size_t column_index = table->get_index_by_name(query.column_);
+    if (column_index == static_cast<size_t>(-1)) {
+        out << "@Column " << query.column_ << " not found" << std::endl;
+        return false;
+    }
+    tablevar new_data;
+    try {
+        new_data = string_to_tablevar(query.value_, table->get_types()[column_index]);
+    } catch (const std::runtime_error& e) {
+        out << e.what() << std::endl;
+        return false;
+    }
 
-void CoolDB::create_query(const std::string& line) {
-    auto tokens = tokenize(line, kSplitNumbers);
-    Table* new_table = find_table(tokens[2]);
-    if (new_table == nullptr) {
-        new_table = new Table(tokens[2]);
-        size_t i = 3;
-        for (; i < tokens.size() - 1 && tokens[i] != "PRIMARY"; i += 2) {
-            new_table->add_column(tokens[i + 1], tokens[i]);
-            if (tokens[i + 1] == "varchar" &&
-                std::all_of(tokens[i + 2].cbegin(), tokens[i + 2].cend(), [](char c) { return std::isdigit(c); }))
-                size_t len = std::stoi(tokens[i++ + 2]);
-        }
-        i += 2;
-        for (; i < tokens.size(); ++i)
-            new_table->add_primary_index(tokens[i]);
-        table_list_.push_back(new_table);
-    } else
-        std::cout << "@Cant create table, already there's table with this name" << std::endl;
+    std::vector<size_t> rows;
+    if (query.where_.empty()) {
+        rows.resize(table->size().second);
+        std::iota(rows.begin(), rows.end(), size_t{0});
+    } else {
+        std::vector<std::forward_list<Condition>> check_list = generate_check_list(query.where_, TableView(table), out);
+        if (check_list.empty())
+            return false;
+        rows = Predicate(table, std::move(check_list)).find_rows(table->size().second);
+    }
+    try {
+        table->update_rows(rows, column_index, new_data);
+    } catch (const std::runtime_error& e) {
+        out << e.what() << std::endl;
+        return false;
+    }
+    return true;
 }
 
-void CoolDB::insert_query(const std::string& line) {
-    auto tokens = tokenize(line, kSplitNumbers);
-    Table* table = find_table(tokens[2]);
-    if (table == nullptr)
-        std::cout << "@Table " << tokens[2] << " not found\n";
-    else {
-        size_t i = 3;
-        if (tokens[i] == "VALUES") {
-            const size_t rows_to_insert = std::count(line.begin(), line.end(), '(');
-            const size_t elements_to_insert = table->size().first;
-            if (rows_to_insert * elements_to_insert != (tokens.size() - i - 1)) {
-                std::cout << "@Column count doesn't match value count" << std::endl;
-                return;
-            }
-            const std::vector<kTypeId>& column_types = table->get_types();
-            ++i;
-            for (; i < tokens.size(); i += elements_to_insert) {
-                Row ins(elements_to_insert);
-                for (size_t j = 0; j < elements_to_insert; ++j)
-                    ins[j] = string_to_tablevar(tokens[i + j], column_types[j]);
-                try {
-                    table->insert_row(ins);
-                } catch (const std::runtime_error& e) {
-                    std::cout << e.what() << std::endl;
-                    return;
-                }
-            }
-        } else {
-            std::vector<size_t> insert_column_indexes;
-            for (; tokens[i] != "VALUES"; ++i) {
-                size_t ind = table->get_index_by_name(tokens[i]);
-                if (ind == -1) {
-                    std::cout << "Wrong column name\n";
-                    return;
-                } else
-                    insert_column_indexes.push_back(ind);
-            }
-            i++;
-            const size_t elements_to_insert = insert_column_indexes.size();
-            const std::vector<kTypeId>& column_types = table->get_types();
-            for (; i < tokens.size(); i += elements_to_insert) {
-                Row ins(table->size().first);
-                for (size_t j = 0; j < elements_to_insert; ++j)
-                    ins[insert_column_indexes[j]] = string_to_tablevar(tokens[i + j], column_types[insert_column_indexes[j]]);
-                try {
-                    table->insert_row(ins);
-                } catch (const std::runtime_error& e) {
-                    std::cout << e.what() << std::endl;
-                    return;
-                }
-            }
-        }
+bool CoolDB::delete_query(const DeleteQuery& query, Table* table, std::ostream& out) {
+    if (query.where_.empty()) {
+        table->clear_table();
+        return true;
     }
+    const size_t n = table->size().second;
+
+    std::vector<std::forward_list<Condition>> check_list = generate_check_list(query.where_, TableView(table), out);
+    const bool found = !check_list.empty();
+    Predicate predicate(table, std::move(check_list));
+    out << predicate.conditions().size() << '\n';
+    table->delete_rows(predicate.find_rows(n));
+    return found;
 }
 
-void CoolDB::drop_query(const std::string& line) {
-    auto tokens = tokenize(line, kSplit);
-    Table* table = find_table(tokens[2]);
-    if (table == nullptr) {
-        std::cout << "@Table " << tokens[2] << " not found\n";
+void CoolDB::select_query(const Statement& statement, const std::vector<std::string_view>& values,
+                          std::ostream& out) {
+    const auto& query = std::get<SelectQuery>(statement.query());
+    // the tables are read as they were when the statement began, writers go on meanwhile.
+    // The handles outlive the pipeline, whose batches point into the tables
+    const bool joined = query.join_ != kJoinId::NONE && query.join_table_ != query.table_;
+    std::vector<Catalog::ReadHandle> handles;
+    if (joined)
+        handles = catalog_.read({query.table_, query.join_table_});
+    else
+        handles.push_back(catalog_.read(query.table_));
+    if (!handles[0]) {
+        out << "@Table " << query.table_ << " not found" << std::endl;
         return;
     }
-    table_list_.erase(std::find(table_list_.begin(), table_list_.end(), table));
-    delete table;
+    // the plan of a table dropped and created again may not fit its columns
+    std::shared_ptr<const SelectPlan> plan = statement.plan();
+    if (plan == nullptr || plan->schema_[0] != handles[0].schema() ||
+        (joined && (!handles[1] || plan->schema_[1] != handles[1].schema()))) {
+        plan = plan_select(statement, handles, out);
+        if (plan == nullptr)
+            return;
+        statement.set_plan(plan);
+    }
+    run_select(statement, *plan, handles, values, out);
 }
 
-void CoolDB::update_query(const std::string& line) {
-    auto tokens = tokenize(line, kSplitOperations);
-    Table* table = find_table(tokens[1]);
-    if (table == nullptr) {
-        std::cout << "@Table " << tokens[1] << " not found\n";
+void CoolDB::prepare_query(const PrepareQuery& query, Session& session, std::ostream& out) {
+    std::shared_ptr<const Statement> statement;
+    try {
+        statement = std::make_shared<const Statement>(std::string(query.statement_));
+    } catch (const std::runtime_error& e) {
+        out << "@Wrong syntax" << std::endl;
         return;
     }
-    size_t column_index = table->get_index_by_name(tokens[3]);
-    tablevar new_data = string_to_tablevar(tokens[5], table->get_types()[column_index]);
-    size_t i = 6;
-
-    if (i >= tokens.size()) {
-        for (size_t j = 0; j < table->size().second; ++j)
-            table->update(j, column_index, new_data);
+    const Query& prepared = statement->query();
+    if (!std::holds_alternative<SelectQuery>(prepared) && !std::holds_alternative<InsertQuery>(prepared) &&
+        !std::holds_alternative<UpdateQuery>(prepared) && !std::holds_alternative<DeleteQuery>(prepared)) {
+        out << "@Can't prepare this statement" << std::endl;
         return;
     }
-    ++i;
-    std::vector<std::forward_list<Condition>> check_list = generate_check_list(tokens, i, table);
+    // a name prepared again gets the new statement
+    session.prepared_.insert_or_assign(std::string(query.name_), std::move(statement));
+}
 
-    for (size_t k = 0; k < table->size().second; ++k)
-        if (table->get_rows()[k].check_condition_list(check_list))
-            table->update(k, column_index, new_data);
+void CoolDB::command_query(const CommandQuery& query, std::ostream& out) {
+    if (query.name_ == "info") {
+        std::vector<Catalog::ReadHandle> handles = catalog_.read_all();
+        out << "Number of tables: " << handles.size() << std::endl;
+        for (size_t i = 0; i < handles.size(); ++i) {
+            out << "------------TABLE " << i + 1 << ":\n";
+            handles[i]->print(out);
+        }
+    } else if (query.name_ == "save") {
+        try {
+            save_to_file("../Data/" + std::string(query.args_[0]));
+        } catch (const std::exception& e) {
+            out << '@' << e.what() << '\n';
+        }
+    } else if (query.name_ == "load") {
+        std::unique_lock lock(log_mutex_);
+        try {
+            load_from_file("../Data/" + std::string(query.args_[0]), out);
+            // tables brought in from outside files go straight to a snapshot instead of the log
+            if (wal_ != nullptr)
+                checkpoint();
+        } catch (const std::exception& e) {
+            out << '@' << e.what() << '\n';
+        }
+    } else if (query.name_ == "open") {
+        size_t flush_interval = 0;
+        if (query.args_.size() > 1)
+            std::from_chars(query.args_[1].data(), query.args_[1].data() + query.args_[1].size(), flush_interval);
+        std::unique_lock lock(log_mutex_);
+        try {
+            open_database(query.args_[0], std::chrono::milliseconds(flush_interval), out);
+        } catch (const std::exception& e) {
+            out << '@' << e.what() << '\n';
+        }
+    } else if (query.name_ == "checkpoint") {
+        std::unique_lock lock(log_mutex_);
+        if (wal_ == nullptr) {
+            out << "@No database is open" << std::endl;
+            return;
+        }
+        try {
+            checkpoint();
+        } catch (const std::exception& e) {
+            out << '@' << e.what() << '\n';
+        }
+    } else if (query.name_ == "copy") {
+        std::unique_lock lock(log_mutex_);
+        Catalog::WriteHandle table = catalog_.write(query.args_[0]);
+        if (!table) {
+            out << "@Table " << query.args_[0] << " not found" << std::endl;
+            return;
+        }
+        size_t threads = 1;
+        if (query.args_.size() > 2)
+            std::from_chars(query.args_[2].data(), query.args_[2].data() + query.args_[2].size(), threads);
+        try {
+            copy_csv(table.get(), "../Data/" + std::string(query.args_[1]), threads);
+            // the table is released first, the snapshot reads it
+            table = Catalog::WriteHandle();
+            if (wal_ != nullptr)
+                checkpoint();
+        } catch (const std::exception& e) {
+            out << '@' << e.what() << '\n';
+        }
+    } else if (query.name_ == "threads") {
+        size_t threads = 0;
+        std::from_chars(query.args_[0].data(), query.args_[0].data() + query.args_[0].size(), threads);
+        if (threads == 0) {
+            out << "@Wrong number of threads" << std::endl;
+            return;
+        }
+        try {
+            ThreadPool::instance().resize(threads);
+        } catch (const std::exception& e) {
+            out << '@' << e.what() << '\n';
+        }
+    }
 }
 
-void CoolDB::delete_query(const std::string& line) {
-    auto tokens = tokenize(line, kSplitOperations);
-    Table* table = find_table(tokens[2]);
-    if (table == nullptr) {
-        std::cout << "@Table " << tokens[2] << " not found" << std::endl;
-        return;
+bool CoolDB::execute(const std::string& line, std::ostream& out, Session& session) {
+    // a SELECT run before skips the parser and the name lookups, only its values are new
+    std::vector<std::string_view> values;
+    std::string text = Statement::normalize(line, values);
+    if (!text.empty()) {
+        std::shared_ptr<const Statement> statement;
+        try {
+            statement = cached_statement(std::move(text));
+        } catch (const std::runtime_error& e) {
+            out << "@Wrong syntax" << std::endl;
+            return true;
+        }
+        select_query(*statement, values, out);
+        return true;
     }
-    if (tokens.size() <= 3) {
-        table->clear_table();
-        return;
-    } else {
-        size_t i = 4;
-        const size_t n = table->size().second;
 
-        auto check_list = generate_check_list(tokens, i, table);
-        std::cout << check_list.size() << '\n';
-        for (int64_t j = n - 1; j >= 0; --j) {
-            if (table->get_rows()[j].check_condition_list(check_list))
-                table->delete_row(j);
+    Query query;
+    try {
+        query = Parser(line).parse();
+    } catch (const std::runtime_error& e) {
+        out << "@Wrong syntax" << std::endl;
+        return true;
+    }
+    if (auto command = std::get_if<CommandQuery>(&query)) {
+        if (command->name_ == "close")
+            return false;
+        // commands that bring in tables from files don't wait for COMMIT
+        if (session.transaction_ != nullptr &&
+            (command->name_ == "load" || command->name_ == "open" || command->name_ == "copy")) {
+            out << "@Can't run in a transaction" << std::endl;
+            return true;
+        }
+        command_query(*command, out);
+        return true;
+    }
+    if (std::holds_alternative<SelectQuery>(query)) {
+        // normalize() takes every SELECT the parser does, this one is run without the cache all the same
+        select_query(Statement(line), {}, out);
+        return true;
+    }
+    if (auto prepare = std::get_if<PrepareQuery>(&query)) {
+        prepare_query(*prepare, session, out);
+        return true;
+    }
+    if (auto deallocate = std::get_if<DeallocateQuery>(&query)) {
+        auto it = session.prepared_.find(deallocate->name_);
+        if (it == session.prepared_.end())
+            out << "@Prepared statement " << deallocate->name_ << " not found" << std::endl;
+        else
+            session.prepared_.erase(it);
+        return true;
+    }
+    // a statement run by EXECUTE is logged with its values written in, the log has no prepared statements
+    std::string bound;
+    if (auto execute = std::get_if<ExecuteQuery>(&query)) {
+        auto it = session.prepared_.find(execute->name_);
+        if (it == session.prepared_.end()) {
+            out << "@Prepared statement " << execute->name_ << " not found" << std::endl;
+            return true;
+        }
+        const Statement& statement = *it->second;
+        if (execute->values_.size() != statement.parameters()) {
+            out << "@Wrong number of values" << std::endl;
+            return true;
+        }
+        if (std::holds_alternative<SelectQuery>(statement.query())) {
+            select_query(statement, execute->values_, out);
+            return true;
+        }
+        bound = statement.text(execute->values_);
+        query = statement.bind(execute->values_);
+    }
+    const std::string& statement_line = bound.empty() ? line : bound;
+
+    std::unique_ptr<Transaction> committed;
+    if (auto transaction = std::get_if<TransactionQuery>(&query)) {
+        if (transaction->op_ == kTransactionId::BEGIN) {
+            if (session.transaction_ != nullptr)
+                out << "@Transaction is already open" << std::endl;
+            else
+                session.transaction_ = std::make_unique<Transaction>();
+            return true;
+        }
+        if (session.transaction_ == nullptr) {
+            out << "@No transaction is open" << std::endl;
+            return true;
+        }
+        committed = std::move(session.transaction_);
+        if (transaction->op_ == kTransactionId::ROLLBACK || committed->empty())
+            return true;
+    } else if (session.transaction_ != nullptr) {
+        add_to_transaction(query, statement_line, *session.transaction_, out);
+        return true;
+    }
 
+    WriteAheadLog* wal;
+    uint64_t lsn;
+    {
+        // CREATE and DROP change the table list, they run alone
+        const bool alone = std::holds_alternative<CreateQuery>(query) || std::holds_alternative<DropQuery>(query);
+        std::shared_lock shared(log_mutex_, std::defer_lock);
+        std::unique_lock exclusive(log_mutex_, std::defer_lock);
+        alone ? exclusive.lock() : shared.lock();
+        wal = wal_.get();
+        lsn = (committed != nullptr ? commit(*committed, out) : apply(query, statement_line, out)).value_or(0);
+    }
+    if (wal == nullptr)
+        return true;
+    // the locks are let go before the record is on disk, so the statements of other threads join its flush
+    try {
+        wal->wait(lsn);
+        if (wal->size() > kCheckpointBytes) {
+            std::unique_lock lock(log_mutex_);
+            if (wal->size() > kCheckpointBytes)
+                checkpoint();
         }
+    } catch (const std::exception& e) {
+        out << '@' << e.what() << '\n';
+    }
+    return true;
+}
+
+std::optional<uint64_t> CoolDB::apply(const Query& query, const std::string& line, std::ostream& out) {
+    // a statement on one table keeps the write lock of the table until the statement is in the log
+    Catalog::WriteHandle table;
+    auto write = [this, &table, &out](std::string_view name) {
+        table = catalog_.write(name);
+        if (!table)
+            out << "@Table " << name << " not found" << std::endl;
+        return static_cast<bool>(table);
+    };
+    bool applied = false;
+    if (auto create = std::get_if<CreateQuery>(&query)) {
+        applied = create_query(*create, out);
+    } else if (auto create_index = std::get_if<CreateIndexQuery>(&query)) {
+        applied = write(create_index->table_) && create_index_query(*create_index, table.get(), out);
+    } else if (auto insert = std::get_if<InsertQuery>(&query)) {
+        applied = write(insert->table_) && insert_query(*insert, table.get(), out);
+    } else if (auto drop = std::get_if<DropQuery>(&query)) {
+        applied = drop_query(*drop, out);
+    } else if (auto update = std::get_if<UpdateQuery>(&query)) {
+        applied = write(update->table_) && update_query(*update, table.get(), out);
+    } else if (auto remove = std::get_if<DeleteQuery>(&query)) {
+        applied = write(remove->table_) && delete_query(*remove, table.get(), out);
     }
+
+    // statements are logged after they are applied, a failed one changed nothing and isn't logged
+    if (!applied)
+        return std::nullopt;
+    return wal_ != nullptr ? wal_->append(line) : 0;
 }
 
-void CoolDB::select_query(const std::string& line) {
-    auto tokens = tokenize(line, kSplitOperations);
-    std::vector<std::string> column_names;
-    std::vector<size_t> column_indexes;
-    Table* table;
-    bool new_table = false;
-    bool all_cols = false;
-    size_t i = 1; // list of columns index
-    if (tokens[i] == "*") {
-        all_cols = true;
-        ++i;
+bool CoolDB::typed_rows(const InsertQuery& query, const Table* table, std::vector<Column>& rows,
+                        std::ostream& out) const {
+    // the value of every column of the table in a row of VALUES, -1 for a column that gets NULL
+    std::vector<size_t> positions(table->size().first, static_cast<size_t>(-1));
+    if (query.columns_.empty()) {
+        std::iota(positions.begin(), positions.end(), size_t{0});
     } else {
-        for (; tokens[i] != "FROM"; ++i)
-            column_names.push_back(tokens[i]);
-    }
-    std::string table_name = tokens[i + 1];
-    i += 2; // next token after FROM
-    table = find_table(table_name);
-    if (table == nullptr) {
-        std::cout << "@Table " << table_name << " not found" << std::endl;
-        return;
+        for (size_t j = 0; j < query.columns_.size(); ++j) {
+            size_t ind = table->get_index_by_name(query.columns_[j]);
+            if (ind == static_cast<size_t>(-1)) {
+                out << "Wrong column name\n";
+                return false;
+            }
+            positions[ind] = j;
+        }
     }
-    if (!(i >= tokens.size() || tokens[i] == "WHERE")) {
-        size_t join_id = i;
-        if (tokens[i] == "JOIN")
-            ++i; // name of the second table index
-        else
-            i += 2; // name of the second table index
-        std::string join_name = tokens[i];
-        Table* join_table = find_table(join_name);
-        if (join_table == nullptr) {
-            std::cout << "@Table " << join_name << " not found" << std::endl;
-            return;
+    const size_t elements_to_insert = query.columns_.empty() ? positions.size() : query.columns_.size();
+    for (const auto& values : query.rows_) {
+        if (values.size() != elements_to_insert) {
+            out << "@Column count doesn't match value count" << std::endl;
+            return false;
+        }
+    }
+
+    const std::vector<kTypeId>& column_types = table->get_types();
+    rows.clear();
+    for (kTypeId type : column_types) {
+        rows.emplace_back(type);
+        rows.back().reserve(query.rows_.size());
+    }
+    try {
+        for (const auto& values : query.rows_)
+            for (size_t i = 0; i < rows.size(); ++i) {
+                if (positions[i] == static_cast<size_t>(-1))
+                    rows[i].push_null();
+                else
+                    rows[i].push_back(string_to_tablevar(values[positions[i]], column_types[i]));
+            }
+    } catch (const std::runtime_error& e) {
+        out << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ............PLANS
+
+std::shared_ptr<const Statement> CoolDB::cached_statement(std::string text) {
+    {
+        std::shared_lock lock(statements_mutex_);
+        auto it = statements_.find(text);
+        if (it != statements_.end())
+            return it->second;
+    }
+    // parsed out of the lock, of two sessions that parse the same new statement the first one's is kept
+    auto statement = std::make_shared<const Statement>(text);
+    std::unique_lock lock(statements_mutex_);
+    // the statements still in use come back with their next run
+    if (statements_.size() >= kMaxStatements)
+        statements_.clear();
+    return statements_.try_emplace(std::move(text), std::move(statement)).first->second;
+}
+
+std::shared_ptr<const SelectPlan> CoolDB::plan_select(const Statement& statement,
+                                                      const std::vector<Catalog::ReadHandle>& tables,
+                                                      std::ostream& out) const {
+    const auto& query = std::get<SelectQuery>(statement.query());
+    auto plan = std::make_shared<SelectPlan>();
+    const Table* table = tables[0].get();
+    plan->schema_[0] = tables[0].schema();
+    // the columns seen by WHERE and the SELECT list
+    TableView shape(table);
+    if (query.join_ != kJoinId::NONE) {
+        const bool joined = tables.size() > 1;
+        if (joined && !tables[1]) {
+            out << "@Table " << query.join_table_ << " not found" << std::endl;
+            return nullptr;
         }
-        i += 2; // first join-column index
-        size_t ind[2];
-        for (size_t k = 0; k < 2; ++k) {
-            auto temp_tokens = tokenize(tokens[i + k * 2], kSplit);
-            if (temp_tokens[0] == table_name) {
-                ind[0] = table->get_index_by_name(temp_tokens[1]);
+        const Table* join_table = joined ? tables[1].get() : table;
+        if (joined)
+            plan->schema_[1] = tables[1].schema();
+        size_t* ind = plan->join_columns_;
+        ind[0] = ind[1] = static_cast<size_t>(-1);
+        for (const ColumnReference& reference : query.on_) {
+            if (reference.table_ == query.table_) {
+                ind[0] = table->get_index_by_name(reference.column_);
                 if (ind[0] == -1) {
-                    std::cout << "@Column " << temp_tokens[1] << " not found" << std::endl;
-                    return;
+                    out << "@Column " << reference.column_ << " not found" << std::endl;
+                    return nullptr;
                 }
-            } else if (temp_tokens[0] == join_name) {
-                ind[1] = join_table->get_index_by_name(temp_tokens[1]);
+            } else if (reference.table_ == query.join_table_) {
+                ind[1] = join_table->get_index_by_name(reference.column_);
                 if (ind[1] == -1) {
-                    std::cout << "@Column " << temp_tokens[1] << " not found" << std::endl;
-                    return;
+                    out << "@Column " << reference.column_ << " not found" << std::endl;
+                    return nullptr;
                 }
             } else {
-                std::cout << "@Table " << temp_tokens[0] << " not found" << std::endl;
-                return;
+                out << "@Table " << reference.table_ << " not found" << std::endl;
+                return nullptr;
             }
         }
-        i += 3; // after second join-column index
-        if (tokens[join_id] == "JOIN" || tokens[join_id] == "INNER")
-            table = table->inner_join(join_table, ind[0], ind[1]);
-        else if (tokens[join_id] == "LEFT")
-            table = table->left_join(join_table, ind[0], ind[1]);
+        if (ind[0] == -1 || ind[1] == -1) {
+            out << "@Wrong syntax" << std::endl;
+            return nullptr;
+        }
+        // nothing is joined before the join is pulled
+        if (query.join_ == kJoinId::RIGHT)
+            shape = JoinOperator(join_table, table, ind[1], ind[0], true).shape();
         else
-            table = table->right_join(join_table, ind[0], ind[1]);
-        new_table = true;
+            shape = JoinOperator(table, join_table, ind[0], ind[1], query.join_ == kJoinId::LEFT).shape();
     }
 
-    if (all_cols) {
-        for (size_t k = 0; k < table->size().first; ++k)
-            column_indexes.push_back(k);
+    // with aggregates the result has the GROUP BY columns, then the aggregates, a plain column must be one of the keys
+    auto is_aggregate = [](const SelectItem& item) { return item.function_ != kAggregateId::NONE; };
+    const bool aggregated = !query.group_by_.empty() ||
+                            std::any_of(query.columns_.begin(), query.columns_.end(), is_aggregate) ||
+                            std::any_of(query.order_by_.begin(), query.order_by_.end(),
+                                        [&](const OrderItem& item) { return is_aggregate(item.column_); });
+    plan->aggregated_ = aggregated;
+    std::vector<size_t>& key_columns = plan->key_columns_;
+    std::vector<AggregateColumn>& aggregates = plan->aggregates_;
+    std::vector<size_t>& column_indexes = plan->column_indexes_;
+    for (std::string_view name : query.group_by_) {
+        size_t col_ind = shape.get_index_by_name(name);
+        if (col_ind == static_cast<size_t>(-1)) {
+            out << "@Column " << name << " not found" << std::endl;
+            return nullptr;
+        }
+        key_columns.push_back(col_ind);
+    }
+    auto result_column = [&](size_t col_ind) {
+        if (!aggregated)
+            return col_ind;
+        auto key = std::find(key_columns.begin(), key_columns.end(), col_ind);
+        if (key == key_columns.end()) {
+            out << "@Column " << shape.get_name(col_ind) << " must be in GROUP BY" << std::endl;
+            return static_cast<size_t>(-1);
+        }
+        return static_cast<size_t>(key - key_columns.begin());
+    };
+    if (query.columns_.empty()) {
+        for (size_t k = 0; k < shape.size().first; ++k) {
+            column_indexes.push_back(result_column(k));
+            if (column_indexes.back() == static_cast<size_t>(-1))
+                return nullptr;
+        }
     } else {
-        for (const auto& name : column_names) {
-            size_t col_ind = table->get_index_by_name(name);
+        for (const SelectItem& item : query.columns_) {
+            size_t col_ind = static_cast<size_t>(-1);
+            if (item.column_ != "*") {
+                col_ind = shape.get_index_by_name(item.column_);
+                if (col_ind == static_cast<size_t>(-1)) {
+                    out << "@Column " << item.column_ << " not found" << std::endl;
+                    return nullptr;
+                }
+            }
+            if (item.function_ != kAggregateId::NONE) {
+                column_indexes.push_back(key_columns.size() + aggregates.size());
+                aggregates.push_back({item.function_, col_ind});
+                continue;
+            }
+            column_indexes.push_back(result_column(col_ind));
+            if (column_indexes.back() == static_cast<size_t>(-1))
+                return nullptr;
+        }
+    }
+    // an aggregate of ORDER BY that isn't selected is computed too, then left out by the projection
+    std::vector<SortColumn>& sort_columns = plan->sort_columns_;
+    for (const OrderItem& item : query.order_by_) {
+        size_t col_ind = static_cast<size_t>(-1);
+        if (item.column_.column_ != "*") {
+            col_ind = shape.get_index_by_name(item.column_.column_);
             if (col_ind == static_cast<size_t>(-1)) {
-                std::cout << "@Column " << name << " not found" << std::endl;
-                return;
+                out << "@Column " << item.column_.column_ << " not found" << std::endl;
+                return nullptr;
             }
-            column_indexes.push_back(col_ind);
         }
+        if (is_aggregate(item.column_)) {
+            auto aggregate = std::find_if(aggregates.begin(), aggregates.end(), [&](const AggregateColumn& other) {
+                return other.function_ == item.column_.function_ && other.column_ == col_ind;
+            });
+            sort_columns.push_back({key_columns.size() + (aggregate - aggregates.begin()), item.descending_});
+            if (aggregate == aggregates.end())
+                aggregates.push_back({item.column_.function_, col_ind});
+            continue;
+        }
+        sort_columns.push_back({result_column(col_ind), item.descending_});
+        if (sort_columns.back().column_ == static_cast<size_t>(-1))
+            return nullptr;
+    }
+    plan->where_ = plan_where(query.where_, shape, &statement);
+    return plan;
+}
+
+void CoolDB::run_select(const Statement& statement, const SelectPlan& plan,
+                        const std::vector<Catalog::ReadHandle>& tables, const std::vector<std::string_view>& values,
+                        std::ostream& out) const {
+    const auto& query = std::get<SelectQuery>(statement.query());
+    const Table* table = tables[0].get();
+    // a WHERE that doesn't bind has printed its error, the query stops there
+    std::vector<std::forward_list<Condition>> check_list;
+    if (!plan.where_.empty()) {
+        check_list = bind_where(plan.where_, values, out);
+        if (check_list.empty())
+            return;
+    }
+    // rows are pulled through the pipeline in batches of views into the tables, no cell is copied before printing
+    std::unique_ptr<Operator> pipeline;
+    if (query.join_ == kJoinId::NONE) {
+        // a single table is filtered by its scan, which compiles the conditions and may use the indexes
+        if (plan.where_.empty())
+            pipeline = std::make_unique<ScanOperator>(table);
+        else
+            pipeline = std::make_unique<ScanOperator>(table, Predicate(table, std::move(check_list)));
+    } else {
+        const Table* join_table = tables.size() > 1 ? tables[1].get() : table;
+        const size_t* ind = plan.join_columns_;
+        // RIGHT JOIN is the LEFT JOIN of the swapped tables
+        if (query.join_ == kJoinId::RIGHT)
+            pipeline = std::make_unique<JoinOperator>(join_table, table, ind[1], ind[0], true);
+        else
+            pipeline = std::make_unique<JoinOperator>(table, join_table, ind[0], ind[1], query.join_ == kJoinId::LEFT);
+        if (!plan.where_.empty())
+            pipeline = std::make_unique<FilterOperator>(std::move(pipeline), std::move(check_list));
+    }
+    try {
+        if (plan.aggregated_)
+            pipeline = std::make_unique<HashAggregateOperator>(std::move(pipeline), plan.key_columns_,
+                                                               plan.aggregates_);
+        // with ORDER BY the sort keeps only the first rows of LIMIT
+        if (!plan.sort_columns_.empty())
+            pipeline = std::make_unique<SortOperator>(std::move(pipeline), plan.sort_columns_, query.limit_);
+        if (query.limit_.has_value())
+            pipeline = std::make_unique<LimitOperator>(std::move(pipeline), *query.limit_);
+        pipeline = std::make_unique<ProjectOperator>(std::move(pipeline), plan.column_indexes_);
+        OutputOperator(std::move(pipeline), out).run();
+    } catch (const std::runtime_error& e) {
+        out << '@' << e.what() << std::endl;
     }
+}
 
-    if (i < tokens.size()) {
-        auto check_list = generate_check_list(tokens, i + 1, table);
-        if (new_table) {
-            Table* temp = table->find(check_list);
-            std::swap(temp, table);
-            delete temp;
-        } else {
-            table = table->find(check_list);
-            new_table = true;
+std::vector<PlannedCondition> CoolDB::plan_where(const WhereClause& where, const TableView& table,
+                                                 const Statement* statement) {
+    std::vector<PlannedCondition> ret;
+    for (size_t i = 0; i < where.size(); ++i) {
+        for (const WhereCondition& condition : where[i]) {
+            PlannedCondition planned{i, condition.not_, table.get_index_by_name(condition.column_), 0,
+                                     kTypeId::NULLOBJ, condition.column_, condition.value_,
+                                     statement != nullptr ? statement->parameter(condition.value_)
+                                                          : static_cast<size_t>(-1)};
+            ret.push_back(planned);
+            // the conditions after a missing column are never looked at
+            if (planned.column_ == static_cast<size_t>(-1))
+                return ret;
+            ret.back().op_ = kOperationsID.at(std::string(condition.op_));
+            ret.back().type_ = table.get_type(planned.column_);
         }
     }
+    return ret;
+}
 
-    Table* result = table->select(column_indexes);
-    if (new_table)
-        delete table;
-    result->print();
-    delete result;
+std::vector<std::forward_list<Condition>> CoolDB::bind_where(const std::vector<PlannedCondition>& where,
+                                                             const std::vector<std::string_view>& values,
+                                                             std::ostream& out) {
+    std::vector<std::forward_list<Condition>> check_list(where.empty() ? 0 : where.back().group_ + 1);
+    for (const PlannedCondition& planned : where) {
+        if (planned.column_ == static_cast<size_t>(-1)) {
+            out << "@Column " << planned.name_ << " not found" << std::endl;
+            return {};
+        }
+        Condition cond;
+        cond.not_ = planned.not_;
+        cond.column_ = planned.column_;
+        cond.op_ = planned.op_;
+        try {
+            cond.data_ = string_to_tablevar(
+                    planned.parameter_ == static_cast<size_t>(-1) ? planned.value_ : values[planned.parameter_],
+                    planned.type_);
+        } catch (const std::exception& e) {
+            out << e.what() << std::endl;
+            return {};
+        }
+        check_list[planned.group_].push_front(std::move(cond));
+    }
+    return check_list;
 }
 
-void CoolDB::start_console() {
-    std::string line;
-    while (std::getline(std::cin, line)) {
-        if (line == kCloseCommand)
+// ............TRANSACTIONS
+
+void CoolDB::add_to_transaction(const Query& query, const std::string& line, Transaction& transaction,
+                                std::ostream& out) {
+    // the tables are looked at as committed so far, only to check the statement before it waits for COMMIT
+    auto read = [this, &out](std::string_view name) {
+        Catalog::ReadHandle table = catalog_.read(name);
+        if (!table)
+            out << "@Table " << name << " not found" << std::endl;
+        return table;
+    };
+    if (auto insert = std::get_if<InsertQuery>(&query)) {
+        Catalog::ReadHandle table = read(insert->table_);
+        std::vector<Column> rows;
+        if (table && typed_rows(*insert, table.get(), rows, out))
+            transaction.insert(insert->table_, std::move(rows), line);
+    } else if (auto update = std::get_if<UpdateQuery>(&query)) {
+        if (read(update->table_))
+            transaction.change(update->table_, line);
+    } else if (auto remove = std::get_if<DeleteQuery>(&query)) {
+        if (read(remove->table_))
+            transaction.change(remove->table_, line);
+    } else {
+        out << "@Can't run in a transaction" << std::endl;
+    }
+}
+
+std::optional<uint64_t> CoolDB::commit(Transaction& transaction, std::ostream& out) {
+    auto& tables = transaction.tables();
+    // a transaction of one batch of rows for one table changes it like an INSERT, append_columns adds all
+    // of them or none. The changes of any other are dropped if a later step fails
+    const bool undoable = tables.size() > 1 || tables.begin()->second.size() > 1 ||
+                          !tables.begin()->second.front().statement_.empty();
+    // every table is taken before any is changed, in name order
+    std::vector<Catalog::WriteHandle> handles;
+    bool done = true;
+    for (const auto& [name, steps] : tables) {
+        handles.push_back(catalog_.write(name));
+        if (!handles.back()) {
+            out << "@Table " << name << " not found" << std::endl;
+            handles.pop_back();
+            done = false;
             break;
-        else if (std::regex_match(line, kCreateReg))
-            create_query(line);
-        else if (std::regex_match(line, kInsertReg))
-            insert_query(line);
-        else if (std::regex_match(line, kDropReg))
-            drop_query(line);
-        else if (std::regex_match(line, kUpdateReg))
-            update_query(line);
-        else if (std::regex_match(line, kDeleteReg))
-            delete_query(line);
-        else if (std::regex_match(line, kSelectReg))
-            select_query(line);
-        else if (line == kInfoCommand) {
-            std::cout << "Number of tables: " << table_list_.size() << std::endl;
-            for (size_t i = 0; i < table_list_.size(); ++i) {
-                std::cout << "------------TABLE " << i + 1 << ":\n";
-                table_list_[i]->print();
-            }
-        } else if (std::regex_match(line, kSaveCommand)) {
-            try {
-                save_to_file("../Data/"+ tokenize(line, kSplitNumbers)[1]);
-            } catch (const std::exception& e) {
-                std::cout << '@' << e.what() << '\n';
-            }
-        } else if (std::regex_match(line, kLoadCommand)) {
-            try {
-                load_from_file("../Data/"+ tokenize(line, kSplitNumbers)[1]);
-            } catch (const std::exception& e) {
-                std::cout << '@' << e.what() << '\n';
+        }
+    }
+    auto handle = handles.begin();
+    for (auto it = tables.begin(); done && it != tables.end(); ++it, ++handle) {
+        Table* table = handle->get();
+        for (Transaction::Step& step : it->second) {
+            if (step.statement_.empty()) {
+                try {
+                    table->append_columns(std::move(step.rows_));
+                } catch (const std::runtime_error& e) {
+                    out << e.what() << std::endl;
+                    done = false;
+                }
+            } else {
+                const Query query = Parser(step.statement_).parse();
+                if (auto update = std::get_if<UpdateQuery>(&query))
+                    done = update_query(*update, table, out);
+                else
+                    done = delete_query(std::get<DeleteQuery>(query), table, out);
             }
+            if (!done)
+                break;
         }
-            
-        else
-            std::cout << "@Wrong syntax" << std::endl;
     }
+    if (!done) {
+        if (undoable)
+            for (Catalog::WriteHandle& taken : handles)
+                taken.discard();
+        out << "@Transaction is rolled back" << std::endl;
+        return std::nullopt;
+    }
+
+    const uint64_t lsn = wal_ != nullptr ? wal_->append(transaction.record()) : 0;
+    Catalog::release(handles);
+    return lsn;
+}
+
+void CoolDB::start_console() {
+    Session session;
+    std::string line;
+    while (std::getline(std::cin, line))
+        if (!execute(line, std::cout, session))
+            break;
 }
@@ -1,31 +1,108 @@
 #pragma once
 
-#include "Table/Table.h"
+#include "Statement.h"
+#include "Transaction.h"
+#include "Table/Catalog.h"
+#include "Table/TableView.h"
+#include "Parser/Query.h"
+#include "Storage/WriteAheadLog.h"
 
-#include <regex>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+// One client of a database, e.g. the console or a connection of the server: the transaction it has open
+// and its prepared statements. A session runs one statement at a time, a transaction left open when it ends
+// is rolled back
+class Session final {
+    friend class CoolDB;
+private:
+    std::unique_ptr<Transaction> transaction_;
+    std::map<std::string, std::shared_ptr<const Statement>, std::less<>> prepared_;
+};
 
 class CoolDB final {
 private:
-    std::vector<Table*> table_list_;
+    Catalog catalog_;
+    // Statements that change data hold it shared from applying the change until it is in the log.
+    // CREATE, DROP, @open, @load, @copy and checkpoints hold it alone, so the log order is the order of the changes
+    std::shared_mutex log_mutex_;
+    // ../Data/<name> of the database opened by @open, its snapshot is <name>.db and log <name>.wal
+    std::string database_;
+    std::unique_ptr<WriteAheadLog> wal_;
+    // SELECTs run before by their normalized text, see Statement::normalize. Every session shares them
+    std::shared_mutex statements_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const Statement>> statements_;
 
     // FILES
     void save_to_file(const std::string& path);
-    void load_from_file(const std::string& path);
+    void load_from_file(const std::string& path, std::ostream& out);
+    void load_from_text_file(const std::string& path, std::ostream& out);
+    // tables of a loaded file, one whose name is taken is left out
+    void add_loaded_table(std::unique_ptr<Table> table, std::ostream& out);
 
-    // Queries
-    void create_query(const std::string& line);
-    void insert_query(const std::string& line);
-    void drop_query(const std::string& line);
-    void update_query(const std::string& line);
-    void delete_query(const std::string& line);
-    void select_query(const std::string& line);
+    // DURABILITY, with log_mutex_ held alone
+    void open_database(std::string_view name, std::chrono::milliseconds flush_interval, std::ostream& out);
+    void checkpoint();
+
+    // Queries, each prints its result and errors to out
+    // the ones that change data return false if they failed and changed nothing
+    bool create_query(const CreateQuery& query, std::ostream& out);
+    // the table of a statement that changes one is held by its write lock
+    bool create_index_query(const CreateIndexQuery& query, Table* table, std::ostream& out);
+    // INSERT, UPDATE and DELETE change all the rows they should or none
+    bool insert_query(const InsertQuery& query, Table* table, std::ostream& out);
+    bool drop_query(const DropQuery& query, std::ostream& out);
+    bool update_query(const UpdateQuery& query, Table* table, std::ostream& out);
+    bool delete_query(const DeleteQuery& query, Table* table, std::ostream& out);
+    // the SELECT of statement with values for its ?, planned again if its tables changed their schema
+    void select_query(const Statement& statement, const std::vector<std::string_view>& values, std::ostream& out);
+    void command_query(const CommandQuery& query, std::ostream& out);
+    void prepare_query(const PrepareQuery& query, Session& session, std::ostream& out);
+
+    // PLANS
+    // the cached statement of a normalized SELECT, parsed and added if it's new.
+    // Throws std::runtime_error on wrong syntax
+    std::shared_ptr<const Statement> cached_statement(std::string text);
+    // the names of the SELECT of statement resolved against its tables, nullptr and the error in out if one is wrong
+    std::shared_ptr<const SelectPlan> plan_select(const Statement& statement,
+                                                  const std::vector<Catalog::ReadHandle>& tables,
+                                                  std::ostream& out) const;
+    void run_select(const Statement& statement, const SelectPlan& plan, const std::vector<Catalog::ReadHandle>& tables,
+                    const std::vector<std::string_view>& values, std::ostream& out) const;
+    // the conditions of where with their columns found in table, a value that is a ? of statement is left to bind
+    static std::vector<PlannedCondition> plan_where(const WhereClause& where, const TableView& table,
+                                                    const Statement* statement);
+    // the check list of planned conditions with values for the ?, empty if a column or a value is wrong
+    static std::vector<std::forward_list<Condition>> bind_where(const std::vector<PlannedCondition>& where,
+                                                                const std::vector<std::string_view>& values,
+                                                                std::ostream& out);
 
     // OTHER
-    Table* find_table(const std::string& name);
-    std::vector<std::string> tokenize(const std::string& line, const std::regex& reg);
-    std::vector<std::forward_list<Condition>> generate_check_list(const std::vector<std::string>& tokens, size_t start_index, Table* table) const;
+    // applies a statement that changes data and appends line to the log if one is open,
+    // returns the log record to wait for, 0 if there's none, nullopt if the statement failed and isn't logged
+    std::optional<uint64_t> apply(const Query& query, const std::string& line, std::ostream& out);
+    // the values of an INSERT as columns typed like the ones of table, false if one doesn't fit
+    bool typed_rows(const InsertQuery& query, const Table* table, std::vector<Column>& rows, std::ostream& out) const;
+    std::vector<std::forward_list<Condition>> generate_check_list(const WhereClause& where,
+                                                                  const TableView& table,
+                                                                  std::ostream& out) const;
+
+    // TRANSACTIONS
+    // adds a statement run between BEGIN and COMMIT to the changes of transaction
+    void add_to_transaction(const Query& query, const std::string& line, Transaction& transaction, std::ostream& out);
+    // applies every change of transaction or none and appends it to the log if one is open,
+    // returns the log record to wait for, 0 if there's none, nullopt if it's rolled back and isn't logged
+    std::optional<uint64_t> commit(Transaction& transaction, std::ostream& out);
 public:
     CoolDB() = default;
-    ~CoolDB();
+    // runs one statement of session and prints its output to out, false on @close.
+    // Safe to call from many threads at once for different sessions.
+    // Between BEGIN and COMMIT the changes of INSERT, UPDATE and DELETE wait in the transaction of the session,
+    // SELECT reads the tables as committed. COMMIT applies them all or, if one fails, none
+    bool execute(const std::string& line, std::ostream& out, Session& session);
     void start_console();
 };
@@ -0,0 +1,514 @@
+#include "Aggregate.h"
+#include "../Table/ThreadPool.h"
+
+#include <bit>
+#include <limits>
+#include <numeric>
+
+const uint32_t kNoGroup = static_cast<uint32_t>(-1);
+const uint64_t kNullKeyHash = 0x2545f4914f6cdd1d;
+const char* const kAggregateNames[] = {"", "COUNT", "SUM", "MIN", "MAX", "AVG"};
+
+static bool is_null(const Column* column, size_t row) { return row == kNoMatch || column->is_null(row); }
+
+template<class T>
+static Column make_column(kTypeId type, std::vector<T> values, Bitmap nulls) {
+    Column column(type);
+    column.assign(std::move(values), std::move(nulls));
+    return column;
+}
+
+static std::vector<int32_t> to_int(const std::vector<int64_t>& values, const std::string& name) {
+    std::vector<int32_t> ret(values.size());
+    for (size_t g = 0; g < values.size(); ++g) {
+        if (values[g] < std::numeric_limits<int32_t>::min() || values[g] > std::numeric_limits<int32_t>::max())
+            throw std::runtime_error{"Integer overflow in " + name};
+        ret[g] = static_cast<int32_t>(values[g]);
+    }
+    return ret;
+}
+
+namespace {
+
+// ...............ACCUMULATORS
+
+// running value of one aggregate in every group
+class Accumulator {
+public:
+    virtual ~Accumulator() = default;
+
+    virtual void resize(size_t groups) = 0;
+    // adds the cells of column at rows to groups, kNoMatch is a NULL cell. COUNT(*) gets no column and no rows
+    virtual void add(const Column* column, const std::vector<size_t>& rows, const std::vector<uint32_t>& groups) = 0;
+    // adds group g of other, an accumulator of the same kind, to group targets[g]
+    virtual void merge(const Accumulator& other, const std::vector<uint32_t>& targets) = 0;
+    // the values of the groups, name is the one of the aggregate for errors
+    virtual Column finish(const std::string& name) const = 0;
+};
+
+class CountAccumulator final : public Accumulator {
+private:
+    // COUNT(*)
+    bool rows_;
+    std::vector<int64_t> counts_;
+public:
+    explicit CountAccumulator(bool rows) : rows_(rows) {}
+
+    void resize(size_t groups) override { counts_.resize(groups); }
+
+    void add(const Column* column, const std::vector<size_t>& rows, const std::vector<uint32_t>& groups) override {
+        for (size_t k = 0; k < groups.size(); ++k)
+            if (rows_ || !is_null(column, rows[k]))
+                ++counts_[groups[k]];
+    }
+
+    void merge(const Accumulator& other, const std::vector<uint32_t>& targets) override {
+        const auto& counts = static_cast<const CountAccumulator&>(other).counts_;
+        for (size_t g = 0; g < counts.size(); ++g)
+            counts_[targets[g]] += counts[g];
+    }
+
+    Column finish(const std::string& name) const override {
+        return make_column(kTypeId::INT, to_int(counts_, name), Bitmap(counts_.size()));
+    }
+};
+
+// SUM or AVG of cells of type T added up as S
+template<class T, class S, bool kAverage>
+class SumAccumulator final : public Accumulator {
+private:
+    std::vector<S> sums_;
+    std::vector<int64_t> counts_;
+public:
+    void resize(size_t groups) override {
+        sums_.resize(groups);
+        counts_.resize(groups);
+    }
+
+    void add(const Column* column, const std::vector<size_t>& rows, const std::vector<uint32_t>& groups) override {
+        const Column::Reader<T> values = column->values<T>();
+        for (size_t k = 0; k < groups.size(); ++k) {
+            if (!is_null(column, rows[k])) {
+                sums_[groups[k]] += static_cast<S>(values[rows[k]]);
+                ++counts_[groups[k]];
+            }
+        }
+    }
+
+    void merge(const Accumulator& other, const std::vector<uint32_t>& targets) override {
+        const auto& accumulator = static_cast<const SumAccumulator&>(other);
+        for (size_t g = 0; g < accumulator.sums_.size(); ++g) {
+            sums_[targets[g]] += accumulator.sums_[g];
+            counts_[targets[g]] += accumulator.counts_[g];
+        }
+    }
+
+    Column finish(const std::string& name) const override {
+        Bitmap nulls(counts_.size());
+        for (size_t g = 0; g < counts_.size(); ++g)
+            if (counts_[g] == 0)
+                nulls.set(g);
+        if constexpr (kAverage) {
+            std::vector<double> averages(sums_.size());
+            for (size_t g = 0; g < sums_.size(); ++g)
+                averages[g] = counts_[g] == 0 ? 0 : static_cast<double>(sums_[g]) / static_cast<double>(counts_[g]);
+            return make_column(kTypeId::DOUBLE, std::move(averages), std::move(nulls));
+        } else if constexpr (std::is_same_v<S, int64_t>) {
+            return make_column(kTypeId::INT, to_int(sums_, name), std::move(nulls));
+        } else {
+            return make_column(kTypeId::DOUBLE, sums_, std::move(nulls));
+        }
+    }
+};
+
+// MIN or MAX of cells of type T
+template<class T, bool kMax>
+class ExtremeAccumulator final : public Accumulator {
+private:
+    kTypeId type_;
+    std::vector<T> values_;
+    std::vector<uint8_t> found_;
+
+    void update(size_t group, const T& value) {
+        if (!found_[group] || (kMax ? values_[group] < value : value < values_[group])) {
+            values_[group] = value;
+            found_[group] = 1;
+        }
+    }
+public:
+    explicit ExtremeAccumulator(kTypeId type) : type_(type) {}
+
+    void resize(size_t groups) override {
+        values_.resize(groups);
+        found_.resize(groups);
+    }
+
+    void add(const Column* column, const std::vector<size_t>& rows, const std::vector<uint32_t>& groups) override {
+        if constexpr (std::is_same_v<T, std::string>) {
+            for (size_t k = 0; k < groups.size(); ++k)
+                if (!is_null(column, rows[k]))
+                    update(groups[k], column->value<T>(rows[k]));
+        } else {
+            const Column::Reader<T> values = column->values<T>();
+            for (size_t k = 0; k < groups.size(); ++k)
+                if (!is_null(column, rows[k]))
+                    update(groups[k], values[rows[k]]);
+        }
+    }
+
+    void merge(const Accumulator& other, const std::vector<uint32_t>& targets) override {
+        const auto& accumulator = static_cast<const ExtremeAccumulator&>(other);
+        for (size_t g = 0; g < accumulator.values_.size(); ++g)
+            if (accumulator.found_[g])
+                update(targets[g], accumulator.values_[g]);
+    }
+
+    // MIN and MAX can't overflow, no error needs the name
+    Column finish(const std::string&) const override {
+        Bitmap nulls(found_.size());
+        for (size_t g = 0; g < found_.size(); ++g)
+            if (!found_[g])
+                nulls.set(g);
+        return make_column(type_, values_, std::move(nulls));
+    }
+};
+
+template<bool kMax>
+std::unique_ptr<Accumulator> make_extreme(kTypeId type) {
+    switch (type) {
+        case kTypeId::INT:
+            return std::make_unique<ExtremeAccumulator<int32_t, kMax>>(type);
+        case kTypeId::FLOAT:
+            return std::make_unique<ExtremeAccumulator<float, kMax>>(type);
+        case kTypeId::DOUBLE:
+            return std::make_unique<ExtremeAccumulator<double, kMax>>(type);
+        case kTypeId::BOOL:
+            return std::make_unique<ExtremeAccumulator<uint8_t, kMax>>(type);
+        case kTypeId::STRING:
+            return std::make_unique<ExtremeAccumulator<std::string, kMax>>(type);
+        default:
+            return std::make_unique<ExtremeAccumulator<Null, kMax>>(type);
+    }
+}
+
+template<bool kAverage>
+std::unique_ptr<Accumulator> make_sum(kTypeId type) {
+    switch (type) {
+        case kTypeId::INT:
+            return std::make_unique<SumAccumulator<int32_t, int64_t, kAverage>>();
+        case kTypeId::FLOAT:
+            return std::make_unique<SumAccumulator<float, double, kAverage>>();
+        default:
+            return std::make_unique<SumAccumulator<double, double, kAverage>>();
+    }
+}
+
+// accumulator typed for a column of type, the type is checked by result_type
+std::unique_ptr<Accumulator> make_accumulator(const AggregateColumn& aggregate, kTypeId type) {
+    switch (aggregate.function_) {
+        case kAggregateId::COUNT:
+            return std::make_unique<CountAccumulator>(aggregate.column_ == static_cast<size_t>(-1));
+        case kAggregateId::SUM:
+            return make_sum<false>(type);
+        case kAggregateId::AVG:
+            return make_sum<true>(type);
+        case kAggregateId::MIN:
+            return make_extreme<false>(type);
+        default:
+            return make_extreme<true>(type);
+    }
+}
+
+// ...............GROUPS
+
+// compares the cells at two rows of a key column, kNoMatch is a NULL cell and NULLs equal each other
+using KeyEqual = bool (*)(const Column&, size_t, size_t);
+
+template<class T>
+Column::Reader<T> key_values(const Column& column) {
+    if constexpr (std::is_same_v<T, uint32_t>)
+        return column.codes();
+    else
+        return column.values<T>();
+}
+
+template<class T>
+decltype(auto) key_value(const Column& column, size_t row) {
+    if constexpr (std::is_same_v<T, uint32_t>)
+        return column.code(row);
+    else
+        return column.value<T>(row);
+}
+
+// T is uint32_t for the codes of a dictionary encoded column
+template<class T>
+bool key_equal(const Column& column, size_t row, size_t other_row) {
+    const bool null = is_null(&column, row);
+    const bool other_null = is_null(&column, other_row);
+    if (null || other_null)
+        return null && other_null;
+    return key_value<T>(column, row) == key_value<T>(column, other_row);
+}
+
+KeyEqual make_key_equal(const Column& column) {
+    if (column.encoded())
+        return key_equal<uint32_t>;
+    switch (column.type()) {
+        case kTypeId::INT:
+            return key_equal<int32_t>;
+        case kTypeId::FLOAT:
+            return key_equal<float>;
+        case kTypeId::DOUBLE:
+            return key_equal<double>;
+        case kTypeId::BOOL:
+            return key_equal<uint8_t>;
+        case kTypeId::STRING:
+            return key_equal<std::string>;
+        default:
+            return key_equal<Null>;
+    }
+}
+
+// open addressing hash table of the group keys of some input rows
+class GroupTable {
+private:
+    std::vector<const Column*> columns_;
+    std::vector<KeyEqual> equals_;
+    // key_rows_[c][g] is the row of the cell of group g in key column c
+    std::vector<std::vector<size_t>> key_rows_;
+    std::vector<uint64_t> hashes_;
+    std::vector<uint32_t> slots_;
+
+    static size_t slot_of(uint64_t hash, size_t mask) { return (hash ^ (hash >> 32)) & mask; }
+
+    void grow() {
+        std::vector<uint32_t> slots(slots_.size() * 2, kNoGroup);
+        const size_t mask = slots.size() - 1;
+        for (uint32_t g = 0; g < hashes_.size(); ++g) {
+            size_t slot = slot_of(hashes_[g], mask);
+            while (slots[slot] != kNoGroup)
+                slot = (slot + 1) & mask;
+            slots[slot] = g;
+        }
+        slots_ = std::move(slots);
+    }
+public:
+    explicit GroupTable(std::vector<const Column*> columns)
+        : columns_(std::move(columns)), key_rows_(columns_.size()), slots_(16, kNoGroup) {
+        for (const Column* column : columns_)
+            equals_.push_back(make_key_equal(*column));
+    }
+
+    size_t size() const { return hashes_.size(); }
+    const std::vector<std::vector<size_t>>& key_rows() const { return key_rows_; }
+    const std::vector<uint64_t>& hashes() const { return hashes_; }
+
+    // the group of the key with the cell rows[c][k] in every key column c, a new group if there's none
+    uint32_t find_or_insert(const std::vector<std::vector<size_t>>& rows, size_t k, uint64_t hash) {
+        if ((hashes_.size() + 1) * 2 > slots_.size())
+            grow();
+        const size_t mask = slots_.size() - 1;
+        for (size_t slot = slot_of(hash, mask);; slot = (slot + 1) & mask) {
+            const uint32_t group = slots_[slot];
+            if (group == kNoGroup) {
+                slots_[slot] = static_cast<uint32_t>(hashes_.size());
+                hashes_.push_back(hash);
+                for (size_t c = 0; c < columns_.size(); ++c)
+                    key_rows_[c].push_back(rows[c][k]);
+                return slots_[slot];
+            }
+            if (hashes_[group] == hash) {
+                bool equal = true;
+                for (size_t c = 0; c < columns_.size() && equal; ++c)
+                    equal = equals_[c](*columns_[c], key_rows_[c][group], rows[c][k]);
+                if (equal)
+                    return group;
+            }
+        }
+    }
+};
+
+template<class T>
+void hash_keys(const Column& column, const std::vector<size_t>& rows, std::vector<uint64_t>& hashes) {
+    const Column::Reader<T> values = key_values<T>(column);
+    for (size_t k = 0; k < rows.size(); ++k) {
+        const uint64_t hash = is_null(&column, rows[k]) ? kNullKeyHash : std::hash<T>{}(values[rows[k]]);
+        hashes[k] = (std::rotl(hashes[k], 29) ^ hash) * 0x9e3779b97f4a7c15;
+    }
+}
+
+// mixes the cells of column at rows into hashes
+void hash_keys(const Column& column, const std::vector<size_t>& rows, std::vector<uint64_t>& hashes) {
+    if (column.encoded())
+        return hash_keys<uint32_t>(column, rows, hashes);
+    switch (column.type()) {
+        case kTypeId::INT:
+            return hash_keys<int32_t>(column, rows, hashes);
+        case kTypeId::FLOAT:
+            return hash_keys<float>(column, rows, hashes);
+        case kTypeId::DOUBLE:
+            return hash_keys<double>(column, rows, hashes);
+        case kTypeId::BOOL:
+            return hash_keys<uint8_t>(column, rows, hashes);
+        case kTypeId::STRING:
+            return hash_keys<std::string>(column, rows, hashes);
+        default:
+            return hash_keys<Null>(column, rows, hashes);
+    }
+}
+
+// the groups of some input rows with their aggregates, in the order of their first rows
+class GroupedAggregates {
+private:
+    const TableView* shape_;
+    const std::vector<size_t>* key_columns_;
+    const std::vector<AggregateColumn>* aggregates_;
+    GroupTable groups_;
+    std::vector<std::unique_ptr<Accumulator>> accumulators_;
+
+    static std::vector<const Column*> key_columns(const TableView& shape, const std::vector<size_t>& key_columns) {
+        std::vector<const Column*> ret;
+        for (size_t column : key_columns)
+            ret.push_back(&shape.base_column(column));
+        return ret;
+    }
+public:
+    GroupedAggregates(const TableView& shape, const std::vector<size_t>& key_columns,
+                      const std::vector<AggregateColumn>& aggregates)
+        : shape_(&shape), key_columns_(&key_columns), aggregates_(&aggregates),
+          groups_(GroupedAggregates::key_columns(shape, key_columns)) {
+        for (const AggregateColumn& aggregate : aggregates)
+            accumulators_.push_back(make_accumulator(aggregate, aggregate.column_ == static_cast<size_t>(-1)
+                                                                ? kTypeId::NULLOBJ : shape.get_type(aggregate.column_)));
+    }
+
+    void add(const TableView& batch) {
+        const size_t n = batch.size().second;
+        std::vector<std::vector<size_t>> keys;
+        std::vector<uint64_t> hashes(n);
+        for (size_t column : *key_columns_) {
+            keys.push_back(batch.base_rows(column));
+            hash_keys(batch.base_column(column), keys.back(), hashes);
+        }
+        std::vector<uint32_t> groups(n);
+        for (size_t k = 0; k < n; ++k)
+            groups[k] = groups_.find_or_insert(keys, k, hashes[k]);
+
+        for (size_t a = 0; a < accumulators_.size(); ++a) {
+            const size_t column = (*aggregates_)[a].column_;
+            accumulators_[a]->resize(groups_.size());
+            if (column == static_cast<size_t>(-1)) {
+                accumulators_[a]->add(nullptr, {}, groups);
+                continue;
+            }
+            accumulators_[a]->add(&batch.base_column(column), batch.base_rows(column), groups);
+        }
+    }
+
+    // the groups of other go after the ones of this, unless this has their keys
+    void merge(const GroupedAggregates& other) {
+        std::vector<uint32_t> targets(other.groups_.size());
+        for (size_t g = 0; g < targets.size(); ++g)
+            targets[g] = groups_.find_or_insert(other.groups_.key_rows(), g, other.groups_.hashes()[g]);
+        for (size_t a = 0; a < accumulators_.size(); ++a) {
+            accumulators_[a]->resize(groups_.size());
+            accumulators_[a]->merge(*other.accumulators_[a], targets);
+        }
+    }
+
+    // the key columns, then the aggregates, one row per group; names are the ones of these columns
+    std::vector<Column> finish(const std::vector<std::string>& names) {
+        if (key_columns_->empty() && groups_.size() == 0) {
+            groups_.find_or_insert({}, 0, 0);
+            for (auto& accumulator : accumulators_)
+                accumulator->resize(1);
+        }
+        std::vector<Column> columns;
+        for (size_t c = 0; c < key_columns_->size(); ++c) {
+            columns.emplace_back(shape_->get_type((*key_columns_)[c]));
+            columns.back().gather(shape_->base_column((*key_columns_)[c]), groups_.key_rows()[c]);
+        }
+        for (size_t a = 0; a < accumulators_.size(); ++a)
+            columns.push_back(accumulators_[a]->finish(names[key_columns_->size() + a]));
+        return columns;
+    }
+};
+
+} // namespace
+
+// the type of the aggregate of a column of type, throws std::runtime_error if it doesn't apply
+static kTypeId result_type(const AggregateColumn& aggregate, kTypeId type, const std::string& name) {
+    switch (aggregate.function_) {
+        case kAggregateId::COUNT:
+            return kTypeId::INT;
+        case kAggregateId::SUM:
+        case kAggregateId::AVG:
+            if (type != kTypeId::INT && type != kTypeId::FLOAT && type != kTypeId::DOUBLE)
+                throw std::runtime_error{"Wrong type for " + name};
+            return aggregate.function_ == kAggregateId::SUM && type == kTypeId::INT ? kTypeId::INT : kTypeId::DOUBLE;
+        default:
+            return type;
+    }
+}
+
+// ...............OPERATOR
+
+HashAggregateOperator::HashAggregateOperator(std::unique_ptr<Operator> child, std::vector<size_t> key_columns,
+                                             std::vector<AggregateColumn> aggregates)
+    : Operator(child->shape()), child_(std::move(child)), key_columns_(std::move(key_columns)),
+      aggregates_(std::move(aggregates)), result_(std::make_unique<Table>(child_->shape().name())) {
+    const TableView& input = child_->shape();
+    for (size_t column : key_columns_)
+        result_->add_column(input.get_type(column), input.get_name(column));
+    for (const AggregateColumn& aggregate : aggregates_) {
+        const bool rows = aggregate.column_ == static_cast<size_t>(-1);
+        const std::string name = std::string(kAggregateNames[static_cast<size_t>(aggregate.function_)]) + '(' +
+                                 (rows ? "*" : input.get_name(aggregate.column_)) + ')';
+        result_->add_column(result_type(aggregate, rows ? kTypeId::NULLOBJ : input.get_type(aggregate.column_), name),
+                            name);
+    }
+    shape_ = TableView(result_.get(), {});
+}
+
+void HashAggregateOperator::aggregate() {
+    std::vector<TableView> batches;
+    while (std::optional<TableView> batch = child_->next())
+        batches.push_back(std::move(*batch));
+
+    // morsels of about kMorselRows input rows, each is aggregated into its own groups
+    std::vector<size_t> bounds = {0};
+    size_t rows = 0;
+    for (size_t b = 0; b < batches.size(); ++b) {
+        rows += batches[b].size().second;
+        if (rows >= kMorselRows || b + 1 == batches.size()) {
+            bounds.push_back(b + 1);
+            rows = 0;
+        }
+    }
+    const TableView& input = child_->shape();
+    std::vector<GroupedAggregates> partials;
+    for (size_t m = 0; m + 1 < std::max<size_t>(bounds.size(), 2); ++m)
+        partials.emplace_back(input, key_columns_, aggregates_);
+    ThreadPool::instance().parallel_for(bounds.size() - 1, [&](size_t m) {
+        for (size_t b = bounds[m]; b < bounds[m + 1]; ++b)
+            partials[m].add(batches[b]);
+    });
+
+    for (size_t m = 1; m < partials.size(); ++m)
+        partials[0].merge(partials[m]);
+    result_->insert_columns(partials[0].finish(result_->get_names()));
+}
+
+std::optional<TableView> HashAggregateOperator::next() {
+    if (!aggregated_) {
+        aggregate();
+        aggregated_ = true;
+    }
+    if (position_ == result_->size().second)
+        return std::nullopt;
+    const size_t end = std::min(result_->size().second, position_ + kBatchRows);
+    std::vector<size_t> row_indexes(end - position_);
+    std::iota(row_indexes.begin(), row_indexes.end(), position_);
+    position_ = end;
+    return TableView(result_.get(), std::move(row_indexes));
+}
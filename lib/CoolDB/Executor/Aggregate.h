@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Operator.h"
+#include "../Parser/Query.h"
+
+// aggregate of a column of the input, column_ is -1 for COUNT(*)
+struct AggregateColumn {
+    kAggregateId function_;
+    size_t column_;
+};
+
+// One row per group of input rows with equal keys: the key columns, then the aggregates named like SUM(price).
+// COUNT counts the rows or the non NULL cells, SUM, MIN, MAX and AVG skip NULLs and give NULL for a group of NULLs.
+// NULL keys form a group, groups come in the order of their first rows; without keys there's always one group.
+// SUM of int is an int and throws std::runtime_error on overflow, SUM of float and AVG are doubles.
+// The input is pulled on the first pull, then morsels of it are aggregated in parallel into their own groups,
+// which are merged in input order
+class HashAggregateOperator final : public Operator {
+private:
+    std::unique_ptr<Operator> child_;
+    std::vector<size_t> key_columns_;
+    std::vector<AggregateColumn> aggregates_;
+    // groups are rows of result_, the batches are views of it
+    std::unique_ptr<Table> result_;
+    size_t position_ = 0;
+    bool aggregated_ = false;
+
+    void aggregate();
+public:
+    // throws std::runtime_error if an aggregate doesn't apply to the type of its column
+    HashAggregateOperator(std::unique_ptr<Operator> child, std::vector<size_t> key_columns,
+                          std::vector<AggregateColumn> aggregates);
+
+    std::optional<TableView> next() override;
+};
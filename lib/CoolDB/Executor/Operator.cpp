@@ -0,0 +1,194 @@
+#include "Operator.h"
+#include "../Table/ThreadPool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iomanip>
+#include <numeric>
+
+// rows [from, to) of view
+static TableView slice(const TableView& view, size_t from, size_t to) {
+    std::vector<size_t> row_indexes(to - from);
+    std::iota(row_indexes.begin(), row_indexes.end(), from);
+    return view.select_rows(row_indexes);
+}
+
+// .......................OPERATOR
+
+Operator::Operator(TableView shape) : shape_(std::move(shape)) {}
+
+const TableView& Operator::shape() const { return shape_; }
+
+// .......................SCAN
+
+ScanOperator::ScanOperator(const Table* table)
+    : Operator(TableView(table, {})), table_(table), rows_(table->size().second) {}
+
+ScanOperator::ScanOperator(const Table* table, Predicate predicate) : ScanOperator(table) {
+    predicate_ = std::move(predicate);
+    if (predicate_->find_indexed(rows_, found_))
+        position_ = rows_;
+}
+
+std::optional<TableView> ScanOperator::next() {
+    if (!predicate_.has_value()) {
+        if (position_ == rows_)
+            return std::nullopt;
+        const size_t end = std::min(rows_, position_ + kBatchRows);
+        std::vector<size_t> row_indexes(end - position_);
+        std::iota(row_indexes.begin(), row_indexes.end(), position_);
+        position_ = end;
+        return TableView(table_, std::move(row_indexes));
+    }
+
+    while (taken_ == found_.size()) {
+        if (position_ == rows_)
+            return std::nullopt;
+        const size_t end = std::min(rows_, position_ + step_);
+        found_ = predicate_->scan_rows(position_, end);
+        taken_ = 0;
+        position_ = end;
+        if (step_ < kMorselRows * ThreadPool::instance().threads())
+            step_ *= 2;
+    }
+    const size_t end = std::min(found_.size(), taken_ + kBatchRows);
+    std::vector<size_t> row_indexes(found_.begin() + taken_, found_.begin() + end);
+    taken_ = end;
+    return TableView(table_, std::move(row_indexes));
+}
+
+// .......................FILTER
+
+FilterOperator::FilterOperator(std::unique_ptr<Operator> child, std::vector<std::forward_list<Condition>> check_list)
+    : Operator(child->shape()), child_(std::move(child)), check_list_(std::move(check_list)) {}
+
+std::optional<TableView> FilterOperator::next() {
+    while (std::optional<TableView> batch = child_->next()) {
+        TableView found = batch->filter(check_list_);
+        if (found.size().second != 0)
+            return found;
+    }
+    return std::nullopt;
+}
+
+// .......................PROJECT
+
+ProjectOperator::ProjectOperator(std::unique_ptr<Operator> child, std::vector<size_t> column_indexes)
+    : Operator(child->shape().project(column_indexes)), child_(std::move(child)),
+      column_indexes_(std::move(column_indexes)) {}
+
+std::optional<TableView> ProjectOperator::next() {
+    std::optional<TableView> batch = child_->next();
+    if (!batch.has_value())
+        return std::nullopt;
+    return batch->project(column_indexes_);
+}
+
+// .......................JOIN
+
+JoinOperator::JoinOperator(const Table* table, const Table* other, size_t column_index, size_t other_column_index,
+                           bool outer)
+    : Operator(TableView(table, {}).join(TableView(other, {}), {})), table_(table), other_(other),
+      column_index_(column_index), other_column_index_(other_column_index), outer_(outer) {}
+
+std::optional<TableView> JoinOperator::next() {
+    if (!pairs_.has_value())
+        pairs_ = table_->join_rows(other_, column_index_, other_column_index_, outer_);
+    if (taken_ == pairs_->size())
+        return std::nullopt;
+    const size_t end = std::min(pairs_->size(), taken_ + kBatchRows);
+    const Table::joinpairs batch(pairs_->begin() + taken_, pairs_->begin() + end);
+    taken_ = end;
+    return TableView(table_).join(TableView(other_), batch);
+}
+
+// .......................LIMIT
+
+LimitOperator::LimitOperator(std::unique_ptr<Operator> child, size_t limit)
+    : Operator(child->shape()), child_(std::move(child)), remaining_(limit) {}
+
+std::optional<TableView> LimitOperator::next() {
+    if (remaining_ == 0)
+        return std::nullopt;
+    std::optional<TableView> batch = child_->next();
+    if (!batch.has_value())
+        return std::nullopt;
+    if (batch->size().second > remaining_)
+        batch = slice(*batch, 0, remaining_);
+    remaining_ -= batch->size().second;
+    return batch;
+}
+
+// .......................OUTPUT
+
+// appends the cell right aligned to kPrintWidth like Row::print, numbers are formatted as by std::ostream
+static void append_cell(std::string& out, const Column& column, size_t row) {
+    char buffer[64];
+    char* end = buffer;
+    std::string_view text;
+    if (row == kNoMatch || column.is_null(row)) {
+        text = "NULL";
+    } else {
+        switch (column.type()) {
+            case kTypeId::INT:
+                end = std::to_chars(buffer, std::end(buffer), column.value<int32_t>(row)).ptr;
+                break;
+            case kTypeId::FLOAT:
+                end = std::to_chars(buffer, std::end(buffer), column.value<float>(row),
+                                    std::chars_format::general, 6).ptr;
+                break;
+            case kTypeId::DOUBLE:
+                end = std::to_chars(buffer, std::end(buffer), column.value<double>(row),
+                                    std::chars_format::general, 6).ptr;
+                break;
+            case kTypeId::BOOL:
+                *end++ = column.value<uint8_t>(row) != 0 ? '1' : '0';
+                break;
+            case kTypeId::STRING:
+                text = column.value<std::string>(row);
+                break;
+            default:
+                text = "NULL";
+                break;
+        }
+        if (end != buffer)
+            text = std::string_view(buffer, end - buffer);
+    }
+    if (text.size() < kPrintWidth)
+        out.append(kPrintWidth - text.size(), ' ');
+    out.append(text);
+    out.push_back(kDelimiter);
+}
+
+OutputOperator::OutputOperator(std::unique_ptr<Operator> child, std::ostream& out)
+    : child_(std::move(child)), out_(out) {}
+
+void OutputOperator::run() {
+    const TableView& shape = child_->shape();
+    const size_t columns = shape.size().first;
+    std::vector<TableView> batches;
+    size_t rows = 0;
+    while (std::optional<TableView> batch = child_->next()) {
+        rows += batch->size().second;
+        batches.push_back(std::move(*batch));
+    }
+
+    out_ << "Table: " << shape.name() << ", " << columns << " cols " << rows << " rows" << '\n';
+    for (size_t k = 0; k < columns; ++k)
+        out_ << std::setw(kPrintWidth) << shape.get_name(k) << '|';
+    out_ << '\n';
+    std::string text;
+    std::vector<std::vector<size_t>> base_rows(columns);
+    for (const TableView& batch : batches) {
+        text.clear();
+        for (size_t k = 0; k < columns; ++k)
+            base_rows[k] = batch.base_rows(k);
+        for (size_t i = 0; i < batch.size().second; ++i) {
+            for (size_t k = 0; k < columns; ++k)
+                append_cell(text, batch.base_column(k), base_rows[k][i]);
+            text.push_back('\n');
+        }
+        out_ << text;
+    }
+    out_ << std::flush;
+}
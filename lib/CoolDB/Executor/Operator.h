@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../Table/TableView.h"
+
+#include <memory>
+#include <optional>
+#include <ostream>
+
+// rows passed from one operator to the next at once
+const size_t kBatchRows = 1024;
+
+// Step of a pull based query pipeline. Every operator returns its rows as batches of at most kBatchRows
+// pulled from its input, so no step but a join holds a whole intermediate result and nothing past the rows
+// a consumer asked for is read. Batches are views into the base tables, no cell is copied before it's printed
+class Operator {
+protected:
+    // the columns of every batch, no rows
+    TableView shape_;
+public:
+    explicit Operator(TableView shape);
+    virtual ~Operator() = default;
+
+    const TableView& shape() const;
+    // the next batch, never empty; nullopt once the input is exhausted
+    virtual std::optional<TableView> next() = 0;
+};
+
+// the rows of a table in order, optionally only the ones matching a predicate
+class ScanOperator final : public Operator {
+private:
+    const Table* table_;
+    size_t rows_;
+    std::optional<Predicate> predicate_;
+    // rows [0, position_) are scanned, found_[taken_, end) are their matches not returned yet
+    size_t position_ = 0;
+    std::vector<size_t> found_;
+    size_t taken_ = 0;
+    // rows scanned at once, it grows so a short read stays cheap and a long one runs on every thread
+    size_t step_ = Predicate::kBlockRows;
+public:
+    explicit ScanOperator(const Table* table);
+    // rows answered by the indexes of predicate are found at once, the others by scanning the table piece by piece
+    ScanOperator(const Table* table, Predicate predicate);
+
+    std::optional<TableView> next() override;
+};
+
+// the rows for which a check list holds, its conditions refer to the columns of the input
+class FilterOperator final : public Operator {
+private:
+    std::unique_ptr<Operator> child_;
+    std::vector<std::forward_list<Condition>> check_list_;
+public:
+    FilterOperator(std::unique_ptr<Operator> child, std::vector<std::forward_list<Condition>> check_list);
+
+    std::optional<TableView> next() override;
+};
+
+// the input columns at column_indexes, in that order
+class ProjectOperator final : public Operator {
+private:
+    std::unique_ptr<Operator> child_;
+    std::vector<size_t> column_indexes_;
+public:
+    ProjectOperator(std::unique_ptr<Operator> child, std::vector<size_t> column_indexes);
+
+    std::optional<TableView> next() override;
+};
+
+// the columns of a table followed by the ones of another, for each pair of their rows with equal keys,
+// ordered by the row of the first table, then by the row of the other. With outer a row of the first table
+// without matches is padded with NULLs. The pairs are found at once on the first pull by Table::join_rows,
+// which merges sorted inputs and joins the others partition by partition on the ThreadPool,
+// then they are returned in batches
+class JoinOperator final : public Operator {
+private:
+    const Table* table_;
+    const Table* other_;
+    size_t column_index_;
+    size_t other_column_index_;
+    bool outer_;
+    std::optional<Table::joinpairs> pairs_;
+    // pairs_[0, taken_) are returned
+    size_t taken_ = 0;
+public:
+    JoinOperator(const Table* table, const Table* other, size_t column_index, size_t other_column_index, bool outer);
+
+    std::optional<TableView> next() override;
+};
+
+// the first limit rows of the input, the input isn't pulled past them
+class LimitOperator final : public Operator {
+private:
+    std::unique_ptr<Operator> child_;
+    size_t remaining_;
+public:
+    LimitOperator(std::unique_ptr<Operator> child, size_t limit);
+
+    std::optional<TableView> next() override;
+};
+
+// End of a pipeline, prints every row in the format of Table::print.
+// The header holds the number of rows, so the batches are kept until the input is exhausted;
+// they only hold row indexes and are formatted one at a time
+class OutputOperator final {
+private:
+    std::unique_ptr<Operator> child_;
+    std::ostream& out_;
+public:
+    OutputOperator(std::unique_ptr<Operator> child, std::ostream& out);
+
+    void run();
+};
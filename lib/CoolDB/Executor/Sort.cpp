@@ -0,0 +1,340 @@
+#include "Sort.h"
+#include "../Table/ThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numeric>
+
+// rows sorted by one thread, a shorter input isn't worth splitting
+const size_t kParallelSortRows = size_t{1} << 16;
+
+// <0, 0 or >0 as lhs orders before, with or after rhs; NaN goes after the numbers
+template<class T>
+static int compare_values(const T& lhs, const T& rhs) {
+    if constexpr (std::is_floating_point_v<T>) {
+        const bool lhs_nan = std::isnan(lhs);
+        const bool rhs_nan = std::isnan(rhs);
+        if (lhs_nan || rhs_nan)
+            return static_cast<int>(lhs_nan) - static_cast<int>(rhs_nan);
+    }
+    if (lhs < rhs)
+        return -1;
+    return rhs < lhs ? 1 : 0;
+}
+
+// sorts items by less, a strict total order: chunks are sorted on the ThreadPool, then merged pairwise
+template<class T, class Less>
+static void parallel_sort(std::vector<T>& items, const Less& less) {
+    ThreadPool& pool = ThreadPool::instance();
+    const size_t n = items.size();
+    if (pool.threads() == 1 || n < kParallelSortRows) {
+        std::sort(items.begin(), items.end(), less);
+        return;
+    }
+    const size_t chunks = std::bit_ceil(std::min(pool.threads(), n / kParallelSortRows));
+    auto bound = [&](size_t chunk) { return std::min(chunk, chunks) * n / chunks; };
+    pool.parallel_for(chunks, [&](size_t c) {
+        std::sort(items.begin() + bound(c), items.begin() + bound(c + 1), less);
+    });
+
+    std::vector<T> merged(n);
+    for (size_t width = 1; width < chunks; width *= 2) {
+        pool.parallel_for(chunks / (2 * width), [&](size_t m) {
+            const size_t from = bound(2 * m * width);
+            const size_t middle = bound((2 * m + 1) * width);
+            const size_t to = bound((2 * m + 2) * width);
+            std::merge(items.begin() + from, items.begin() + middle, items.begin() + middle, items.begin() + to,
+                       merged.begin() + from, less);
+        });
+        items.swap(merged);
+    }
+}
+
+namespace {
+
+// ...............KEYS
+
+// the cells of one ORDER BY column at the rows of a view
+class KeyColumn {
+public:
+    virtual ~KeyColumn() = default;
+
+    // <0, 0 or >0 as row i orders before, with or after row j of other, a key of the same column
+    virtual int compare(size_t i, const KeyColumn& other, size_t j) const = 0;
+};
+
+template<class T>
+class TypedKeyColumn final : public KeyColumn {
+public:
+    // strings are compared in place, the view keeps their table
+    using Value = std::conditional_t<std::is_same_v<T, std::string>, std::string_view, T>;
+
+    std::vector<Value> values_;
+    std::vector<uint8_t> nulls_;
+    bool descending_;
+
+    TypedKeyColumn(const TableView& view, const SortColumn& column) : descending_(column.descending_) {
+        const Column& base = view.base_column(column.column_);
+        const std::vector<size_t> rows = view.base_rows(column.column_);
+        values_.resize(rows.size());
+        nulls_.resize(rows.size());
+        for (size_t k = 0; k < rows.size(); ++k) {
+            if (rows[k] == kNoMatch || base.is_null(rows[k]))
+                nulls_[k] = 1;
+            else if constexpr (std::is_same_v<T, std::string>)
+                values_[k] = base.value<T>(rows[k]);
+            else
+                values_[k] = base.value<T>(rows[k]);
+        }
+    }
+
+    int compare(size_t i, const KeyColumn& other, size_t j) const override {
+        const auto& key = static_cast<const TypedKeyColumn&>(other);
+        int ret;
+        if (nulls_[i] || key.nulls_[j])
+            ret = static_cast<int>(nulls_[i]) - static_cast<int>(key.nulls_[j]);
+        else
+            ret = compare_values<Value>(values_[i], key.values_[j]);
+        return descending_ ? -ret : ret;
+    }
+};
+
+std::unique_ptr<KeyColumn> make_key_column(const TableView& view, const SortColumn& column) {
+    switch (view.get_type(column.column_)) {
+        case kTypeId::INT:
+            return std::make_unique<TypedKeyColumn<int32_t>>(view, column);
+        case kTypeId::FLOAT:
+            return std::make_unique<TypedKeyColumn<float>>(view, column);
+        case kTypeId::DOUBLE:
+            return std::make_unique<TypedKeyColumn<double>>(view, column);
+        case kTypeId::BOOL:
+            return std::make_unique<TypedKeyColumn<uint8_t>>(view, column);
+        case kTypeId::STRING:
+            return std::make_unique<TypedKeyColumn<std::string>>(view, column);
+        default:
+            return std::make_unique<TypedKeyColumn<Null>>(view, column);
+    }
+}
+
+// the ORDER BY keys of every row of a view
+class SortKeys {
+private:
+    std::vector<std::unique_ptr<KeyColumn>> columns_;
+public:
+    SortKeys(const TableView& view, const std::vector<SortColumn>& columns) {
+        for (const SortColumn& column : columns)
+            columns_.push_back(make_key_column(view, column));
+    }
+
+    int compare(size_t i, const SortKeys& other, size_t j) const {
+        for (size_t c = 0; c < columns_.size(); ++c)
+            if (int ret = columns_[c]->compare(i, *other.columns_[c], j); ret != 0)
+                return ret;
+        return 0;
+    }
+};
+
+// ...............SORT
+
+// the rows of one key in order, non NULL keys are sorted as (value, row) pairs
+template<class Value>
+std::vector<size_t> sorted_rows(const std::vector<Value>& values, const std::vector<uint8_t>& null_keys,
+                                bool descending) {
+    std::vector<std::pair<Value, size_t>> items;
+    std::vector<size_t> nulls;
+    for (size_t k = 0; k < null_keys.size(); ++k) {
+        if (null_keys[k])
+            nulls.push_back(k);
+        else
+            items.emplace_back(values[k], k);
+    }
+    parallel_sort(items, [descending](const auto& lhs, const auto& rhs) {
+        const int ret = compare_values<Value>(lhs.first, rhs.first);
+        if (ret != 0)
+            return descending ? ret > 0 : ret < 0;
+        return lhs.second < rhs.second;
+    });
+
+    std::vector<size_t> rows;
+    rows.reserve(null_keys.size());
+    if (descending)
+        rows.insert(rows.end(), nulls.begin(), nulls.end());
+    for (const auto& item : items)
+        rows.push_back(item.second);
+    if (!descending)
+        rows.insert(rows.end(), nulls.begin(), nulls.end());
+    return rows;
+}
+
+template<class T>
+std::vector<size_t> sorted_rows(const TypedKeyColumn<T>& key) {
+    return sorted_rows(key.values_, key.nulls_, key.descending_);
+}
+
+// strings of a dictionary encoded column are sorted by the ranks of their codes
+std::vector<size_t> sorted_codes(const TableView& view, const SortColumn& column) {
+    const Column& base = view.base_column(column.column_);
+    const std::vector<uint32_t> ranks = base.dictionary().ranks();
+    const std::vector<size_t> rows = view.base_rows(column.column_);
+    std::vector<uint32_t> values(rows.size());
+    std::vector<uint8_t> nulls(rows.size());
+    for (size_t k = 0; k < rows.size(); ++k) {
+        if (rows[k] == kNoMatch || base.is_null(rows[k]))
+            nulls[k] = 1;
+        else
+            values[k] = ranks[base.code(rows[k])];
+    }
+    return sorted_rows(values, nulls, column.descending_);
+}
+
+// the rows of view in order, ties in row order
+std::vector<size_t> sorted_rows(const TableView& view, const std::vector<SortColumn>& columns) {
+    if (columns.size() == 1) {
+        switch (view.get_type(columns[0].column_)) {
+            case kTypeId::INT:
+                return sorted_rows(TypedKeyColumn<int32_t>(view, columns[0]));
+            case kTypeId::FLOAT:
+                return sorted_rows(TypedKeyColumn<float>(view, columns[0]));
+            case kTypeId::DOUBLE:
+                return sorted_rows(TypedKeyColumn<double>(view, columns[0]));
+            case kTypeId::BOOL:
+                return sorted_rows(TypedKeyColumn<uint8_t>(view, columns[0]));
+            case kTypeId::STRING:
+                if (view.base_column(columns[0].column_).encoded())
+                    return sorted_codes(view, columns[0]);
+                return sorted_rows(TypedKeyColumn<std::string>(view, columns[0]));
+            default:
+                break;
+        }
+    }
+    const SortKeys keys(view, columns);
+    std::vector<size_t> rows(view.size().second);
+    std::iota(rows.begin(), rows.end(), size_t{0});
+    parallel_sort(rows, [&keys](size_t lhs, size_t rhs) {
+        const int ret = keys.compare(lhs, keys, rhs);
+        return ret != 0 ? ret < 0 : lhs < rhs;
+    });
+    return rows;
+}
+
+} // namespace
+
+// ...............OPERATOR
+
+SortOperator::SortOperator(std::unique_ptr<Operator> child, std::vector<SortColumn> columns,
+                           std::optional<size_t> limit)
+    : Operator(child->shape()), child_(std::move(child)), columns_(std::move(columns)), limit_(limit) {}
+
+TableView SortOperator::sort_all() {
+    std::vector<TableView> batches;
+    while (std::optional<TableView> batch = child_->next())
+        batches.push_back(std::move(*batch));
+    const TableView rows = shape_.concat(batches);
+    return rows.select_rows(sorted_rows(rows, columns_));
+}
+
+TableView SortOperator::top(size_t limit) {
+    // kept holds the first rows of the input read so far, heap orders its positions with the last of them on top.
+    // A row of the input is a candidate if it goes before that top, candidates are pushed in groups of at least
+    // limit rows, so rebuilding kept costs O(1) per row
+    TableView kept = shape_;
+    std::optional<SortKeys> kept_keys;
+    std::vector<size_t> heap;
+    // input position of every row of kept, it orders equal keys
+    std::vector<size_t> order;
+    std::vector<TableView> candidates;
+    std::vector<size_t> candidate_order;
+    size_t read = 0;
+
+    auto push_candidates = [&]() {
+        const TableView rows = kept.concat(candidates);
+        const SortKeys keys(rows, columns_);
+        order.insert(order.end(), candidate_order.begin(), candidate_order.end());
+        auto before = [&](size_t lhs, size_t rhs) {
+            const int ret = keys.compare(lhs, keys, rhs);
+            return ret != 0 ? ret < 0 : order[lhs] < order[rhs];
+        };
+        for (size_t p = kept.size().second; p < rows.size().second; ++p) {
+            if (heap.size() < limit) {
+                heap.push_back(p);
+                std::push_heap(heap.begin(), heap.end(), before);
+            } else if (before(p, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = p;
+                std::push_heap(heap.begin(), heap.end(), before);
+            }
+        }
+
+        // kept takes the rows in heap order, so the heap stays valid on their new positions
+        std::vector<size_t> kept_order(heap.size());
+        for (size_t k = 0; k < heap.size(); ++k)
+            kept_order[k] = order[heap[k]];
+        kept = rows.select_rows(heap);
+        std::iota(heap.begin(), heap.end(), size_t{0});
+        order = std::move(kept_order);
+        kept_keys.emplace(kept, columns_);
+        candidates.clear();
+        candidate_order.clear();
+    };
+
+    size_t pending = 0;
+    while (std::optional<TableView> batch = child_->next()) {
+        const size_t n = batch->size().second;
+        if (heap.size() < limit) {
+            for (size_t i = 0; i < n; ++i)
+                candidate_order.push_back(read + i);
+            pending += n;
+            candidates.push_back(std::move(*batch));
+        } else {
+            const SortKeys keys(*batch, columns_);
+            std::vector<size_t> rows;
+            for (size_t i = 0; i < n; ++i)
+                if (keys.compare(i, *kept_keys, 0) < 0)
+                    rows.push_back(i);
+            for (size_t i : rows)
+                candidate_order.push_back(read + i);
+            pending += rows.size();
+            if (!rows.empty())
+                candidates.push_back(batch->select_rows(rows));
+        }
+        read += n;
+        if (pending > std::max(limit, kBatchRows)) {
+            push_candidates();
+            pending = 0;
+        }
+    }
+    // an input that never outgrew the limit is sorted whole, the candidates are all its batches
+    if (heap.empty()) {
+        const TableView rows = shape_.concat(candidates);
+        std::vector<size_t> sorted = sorted_rows(rows, columns_);
+        sorted.resize(std::min(sorted.size(), limit));
+        return rows.select_rows(sorted);
+    }
+    if (!candidates.empty())
+        push_candidates();
+
+    std::vector<size_t> rows(kept.size().second);
+    std::iota(rows.begin(), rows.end(), size_t{0});
+    std::sort(rows.begin(), rows.end(), [&](size_t lhs, size_t rhs) {
+        const int ret = kept_keys->compare(lhs, *kept_keys, rhs);
+        return ret != 0 ? ret < 0 : order[lhs] < order[rhs];
+    });
+    return kept.select_rows(rows);
+}
+
+std::optional<TableView> SortOperator::next() {
+    if (!sorted_.has_value()) {
+        if (limit_.has_value() && *limit_ == 0)
+            sorted_ = shape_;
+        else
+            sorted_ = limit_.has_value() ? top(*limit_) : sort_all();
+    }
+    if (position_ == sorted_->size().second)
+        return std::nullopt;
+    const size_t end = std::min(sorted_->size().second, position_ + kBatchRows);
+    std::vector<size_t> row_indexes(end - position_);
+    std::iota(row_indexes.begin(), row_indexes.end(), position_);
+    position_ = end;
+    return sorted_->select_rows(row_indexes);
+}
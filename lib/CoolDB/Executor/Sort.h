@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Operator.h"
+
+// ORDER BY column of the input
+struct SortColumn {
+    size_t column_;
+    bool descending_ = false;
+};
+
+// The input ordered by the columns, rows with equal keys keep their input order.
+// NULLs go after every value, before them with DESC. Keys are copied out of the columns as typed values,
+// so no tablevar is compared. The input is pulled on the first pull: with a limit only the first limit rows
+// are kept in a heap while it's read, otherwise every row is sorted in chunks on the ThreadPool and merged
+class SortOperator final : public Operator {
+private:
+    std::unique_ptr<Operator> child_;
+    std::vector<SortColumn> columns_;
+    std::optional<size_t> limit_;
+    std::optional<TableView> sorted_;
+    size_t position_ = 0;
+
+    TableView sort_all();
+    TableView top(size_t limit);
+public:
+    SortOperator(std::unique_ptr<Operator> child, std::vector<SortColumn> columns, std::optional<size_t> limit);
+
+    std::optional<TableView> next() override;
+};
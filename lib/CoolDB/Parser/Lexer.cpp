@@ -0,0 +1,84 @@
+#include "Lexer.h"
+
+#include <cctype>
+
+static bool is_word_char(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+static bool is_digit(char c) { return std::isdigit(static_cast<unsigned char>(c)); }
+
+Lexer::Lexer(std::string_view line) : line_(line) {}
+
+void Lexer::skip_spaces() {
+    while (pos_ < line_.size() && std::isspace(static_cast<unsigned char>(line_[pos_])))
+        ++pos_;
+}
+
+std::string_view Lexer::take_word() {
+    const size_t start = pos_;
+    while (pos_ < line_.size() && is_word_char(line_[pos_]))
+        ++pos_;
+    return line_.substr(start, pos_ - start);
+}
+
+Token Lexer::next() {
+    skip_spaces();
+    if (pos_ >= line_.size())
+        return {kTokenId::END, {}};
+
+    const size_t start = pos_;
+    const char c = line_[pos_];
+
+    // numbers: -?digits(.digits)?, a word that starts with digits is an identifier
+    if (is_digit(c) || (c == '-' && pos_ + 1 < line_.size() && is_digit(line_[pos_ + 1]))) {
+        ++pos_;
+        while (pos_ < line_.size() && is_digit(line_[pos_]))
+            ++pos_;
+        if (pos_ < line_.size() && is_word_char(line_[pos_]) && c != '-') {
+            take_word();
+            return {kTokenId::IDENTIFIER, line_.substr(start, pos_ - start)};
+        }
+        if (pos_ < line_.size() && line_[pos_] == '.') {
+            ++pos_;
+            while (pos_ < line_.size() && is_digit(line_[pos_]))
+                ++pos_;
+        }
+        return {kTokenId::NUMBER, line_.substr(start, pos_ - start)};
+    }
+
+    if (is_word_char(c))
+        return {kTokenId::IDENTIFIER, take_word()};
+
+    switch (c) {
+        case '\'': {
+            const size_t end = line_.find('\'', pos_ + 1);
+            if (end == std::string_view::npos)
+                return {kTokenId::ERROR, line_.substr(start)};
+            pos_ = end + 1;
+            return {kTokenId::STRING, line_.substr(start + 1, end - start - 1)};
+        }
+        case '@':
+            ++pos_;
+            return {kTokenId::COMMAND, take_word()};
+        case '!':
+        case '>':
+        case '<':
+            ++pos_;
+            if (pos_ < line_.size() && line_[pos_] == '=')
+                ++pos_;
+            else if (c == '!')
+                return {kTokenId::ERROR, line_.substr(start, 1)};
+            return {kTokenId::SYMBOL, line_.substr(start, pos_ - start)};
+        case '(':
+        case ')':
+        case ',':
+        case ';':
+        case '.':
+        case '*':
+        case '=':
+        case '?':
+            ++pos_;
+            return {kTokenId::SYMBOL, line_.substr(start, 1)};
+        default:
+            return {kTokenId::ERROR, line_.substr(start, 1)};
+    }
+}
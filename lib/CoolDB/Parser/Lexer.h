@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+enum class kTokenId : uint8_t {IDENTIFIER = 0, NUMBER = 1, STRING = 2, SYMBOL = 3, COMMAND = 4, END = 5, ERROR = 6};
+
+// Token text points into the scanned line: quotes are cut off strings, '@' off commands
+struct Token {
+    kTokenId type_;
+    std::string_view text_;
+};
+
+// Single pass scanner over one statement, nothing is copied out of the line
+class Lexer final {
+private:
+    std::string_view line_;
+    size_t pos_ = 0;
+
+    void skip_spaces();
+    std::string_view take_word();
+public:
+    explicit Lexer(std::string_view line);
+
+    Token next();
+};
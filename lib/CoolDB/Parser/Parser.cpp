@@ -0,0 +1,472 @@
+#include "Parser.h"
+
+#include <charconv>
+#include <stdexcept>
+
+Parser::Parser(std::string_view line, bool placeholders)
+        : lexer_(line), current_(lexer_.next()), placeholders_(placeholders) {}
+
+const std::vector<std::string_view>& Parser::parameters() const { return parameters_; }
+
+// ...............TOKENS
+
+void Parser::advance() {
+    if (current_.type_ == kTokenId::ERROR)
+        throw std::runtime_error{"Wrong syntax"};
+    current_ = lexer_.next();
+}
+
+bool Parser::is_keyword(std::string_view keyword) const {
+    return current_.type_ == kTokenId::IDENTIFIER && current_.text_ == keyword;
+}
+
+bool Parser::accept_keyword(std::string_view keyword) {
+    if (!is_keyword(keyword))
+        return false;
+    advance();
+    return true;
+}
+
+void Parser::expect_keyword(std::string_view keyword) {
+    if (!accept_keyword(keyword))
+        throw std::runtime_error{"Wrong syntax"};
+}
+
+bool Parser::accept_symbol(std::string_view symbol) {
+    if (current_.type_ != kTokenId::SYMBOL || current_.text_ != symbol)
+        return false;
+    advance();
+    return true;
+}
+
+void Parser::expect_symbol(std::string_view symbol) {
+    if (!accept_symbol(symbol))
+        throw std::runtime_error{"Wrong syntax"};
+}
+
+std::string_view Parser::expect_identifier() {
+    if (current_.type_ != kTokenId::IDENTIFIER)
+        throw std::runtime_error{"Wrong syntax"};
+    std::string_view ret = current_.text_;
+    advance();
+    return ret;
+}
+
+std::string_view Parser::expect_value() {
+    if (placeholders_ && current_.type_ == kTokenId::SYMBOL && current_.text_ == "?") {
+        parameters_.push_back(current_.text_);
+        advance();
+        return parameters_.back();
+    }
+    if (current_.type_ != kTokenId::NUMBER && current_.type_ != kTokenId::STRING && current_.type_ != kTokenId::IDENTIFIER)
+        throw std::runtime_error{"Wrong syntax"};
+    std::string_view ret = current_.text_;
+    advance();
+    return ret;
+}
+
+std::string_view Parser::expect_file_name() {
+    // name.extension
+    std::string_view name = expect_identifier();
+    expect_symbol(".");
+    std::string_view extension = expect_identifier();
+    return {name.data(), static_cast<size_t>(extension.data() + extension.size() - name.data())};
+}
+
+std::string_view Parser::expect_count() {
+    // unsigned integer
+    if (current_.type_ != kTokenId::NUMBER || current_.text_.front() == '-' ||
+        current_.text_.find('.') != std::string_view::npos)
+        throw std::runtime_error{"Wrong syntax"};
+    std::string_view ret = current_.text_;
+    advance();
+    return ret;
+}
+
+void Parser::expect_end() {
+    if (current_.type_ != kTokenId::END)
+        throw std::runtime_error{"Wrong syntax"};
+}
+
+// ...............STATEMENTS
+
+Query Parser::parse() {
+    Query ret;
+    if (current_.type_ == kTokenId::COMMAND)
+        ret = parse_command();
+    else if (accept_keyword("CREATE")) {
+        if (is_keyword("INDEX"))
+            ret = parse_create_index();
+        else
+            ret = parse_create();
+    }
+    else if (is_keyword("INSERT"))
+        ret = parse_insert();
+    else if (is_keyword("DROP"))
+        ret = parse_drop();
+    else if (is_keyword("UPDATE"))
+        ret = parse_update();
+    else if (is_keyword("DELETE"))
+        ret = parse_delete();
+    else if (is_keyword("SELECT"))
+        ret = parse_select();
+    else if (is_keyword("BEGIN") || is_keyword("COMMIT") || is_keyword("ROLLBACK"))
+        ret = parse_transaction();
+    else if (is_keyword("PREPARE"))
+        ret = parse_prepare();
+    else if (is_keyword("EXECUTE"))
+        ret = parse_execute();
+    else if (is_keyword("DEALLOCATE"))
+        ret = parse_deallocate();
+    else
+        throw std::runtime_error{"Wrong syntax"};
+    expect_end();
+
+    return ret;
+}
+
+CreateQuery Parser::parse_create() {
+    // CREATE TABLE name (column type, ... [, PRIMARY KEY (column, ...)]);
+    CreateQuery query;
+    expect_keyword("TABLE");
+    query.table_ = expect_identifier();
+    expect_symbol("(");
+    do {
+        if (accept_keyword("PRIMARY")) {
+            expect_keyword("KEY");
+            expect_symbol("(");
+            do {
+                query.primary_key_.push_back(expect_identifier());
+            } while (accept_symbol(","));
+            expect_symbol(")");
+            break;
+        }
+        query.columns_.push_back(parse_column_definition());
+    } while (accept_symbol(","));
+    expect_symbol(")");
+    expect_symbol(";");
+    if (query.columns_.empty())
+        throw std::runtime_error{"Wrong syntax"};
+
+    return query;
+}
+
+CreateIndexQuery Parser::parse_create_index() {
+    // CREATE INDEX name ON table (column);
+    CreateIndexQuery query;
+    expect_keyword("INDEX");
+    query.name_ = expect_identifier();
+    expect_keyword("ON");
+    query.table_ = expect_identifier();
+    expect_symbol("(");
+    query.column_ = expect_identifier();
+    expect_symbol(")");
+    expect_symbol(";");
+
+    return query;
+}
+
+InsertQuery Parser::parse_insert() {
+    // INSERT INTO name [(column, ...)] VALUES (value, ...), ...;
+    InsertQuery query;
+    expect_keyword("INSERT");
+    expect_keyword("INTO");
+    query.table_ = expect_identifier();
+    if (accept_symbol("(")) {
+        do {
+            query.columns_.push_back(expect_identifier());
+        } while (accept_symbol(","));
+        expect_symbol(")");
+    }
+    expect_keyword("VALUES");
+    do {
+        expect_symbol("(");
+        query.rows_.emplace_back();
+        do {
+            query.rows_.back().push_back(expect_value());
+        } while (accept_symbol(","));
+        expect_symbol(")");
+    } while (accept_symbol(","));
+    expect_symbol(";");
+
+    return query;
+}
+
+DropQuery Parser::parse_drop() {
+    // DROP TABLE name;
+    DropQuery query;
+    expect_keyword("DROP");
+    expect_keyword("TABLE");
+    query.table_ = expect_identifier();
+    expect_symbol(";");
+
+    return query;
+}
+
+UpdateQuery Parser::parse_update() {
+    // UPDATE name SET column = value [WHERE ...];
+    UpdateQuery query;
+    expect_keyword("UPDATE");
+    query.table_ = expect_identifier();
+    expect_keyword("SET");
+    query.column_ = expect_identifier();
+    expect_symbol("=");
+    query.value_ = expect_value();
+    if (accept_keyword("WHERE"))
+        query.where_ = parse_where();
+    expect_symbol(";");
+
+    return query;
+}
+
+DeleteQuery Parser::parse_delete() {
+    // DELETE FROM name [WHERE ...];
+    DeleteQuery query;
+    expect_keyword("DELETE");
+    expect_keyword("FROM");
+    query.table_ = expect_identifier();
+    if (accept_keyword("WHERE"))
+        query.where_ = parse_where();
+    expect_symbol(";");
+
+    return query;
+}
+
+SelectQuery Parser::parse_select() {
+    // SELECT *|item, ... FROM name [[INNER|LEFT|RIGHT] JOIN name ON t.column = t.column] [WHERE ...]
+    // [GROUP BY column, ...] [ORDER BY item [ASC|DESC], ...] [LIMIT n];
+    SelectQuery query;
+    expect_keyword("SELECT");
+    if (!accept_symbol("*")) {
+        do {
+            query.columns_.push_back(parse_select_item());
+        } while (accept_symbol(","));
+    }
+    expect_keyword("FROM");
+    query.table_ = expect_identifier();
+
+    if (accept_keyword("INNER"))
+        query.join_ = kJoinId::INNER;
+    else if (accept_keyword("LEFT"))
+        query.join_ = kJoinId::LEFT;
+    else if (accept_keyword("RIGHT"))
+        query.join_ = kJoinId::RIGHT;
+    if (query.join_ != kJoinId::NONE || is_keyword("JOIN")) {
+        expect_keyword("JOIN");
+        if (query.join_ == kJoinId::NONE)
+            query.join_ = kJoinId::INNER;
+        query.join_table_ = expect_identifier();
+        expect_keyword("ON");
+        query.on_[0] = parse_column_reference();
+        expect_symbol("=");
+        query.on_[1] = parse_column_reference();
+    }
+
+    if (accept_keyword("WHERE"))
+        query.where_ = parse_where();
+    if (accept_keyword("GROUP")) {
+        expect_keyword("BY");
+        do {
+            query.group_by_.push_back(expect_identifier());
+        } while (accept_symbol(","));
+    }
+    if (accept_keyword("ORDER")) {
+        expect_keyword("BY");
+        do {
+            OrderItem item{parse_select_item()};
+            if (accept_keyword("DESC"))
+                item.descending_ = true;
+            else
+                accept_keyword("ASC");
+            query.order_by_.push_back(item);
+        } while (accept_symbol(","));
+    }
+    if (accept_keyword("LIMIT")) {
+        std::string_view count = expect_count();
+        size_t limit = 0;
+        if (std::from_chars(count.data(), count.data() + count.size(), limit).ec != std::errc())
+            throw std::runtime_error{"Wrong syntax"};
+        query.limit_ = limit;
+    }
+    expect_symbol(";");
+
+    return query;
+}
+
+TransactionQuery Parser::parse_transaction() {
+    // BEGIN; | COMMIT; | ROLLBACK;
+    TransactionQuery query;
+    if (accept_keyword("BEGIN"))
+        query.op_ = kTransactionId::BEGIN;
+    else if (accept_keyword("COMMIT"))
+        query.op_ = kTransactionId::COMMIT;
+    else {
+        expect_keyword("ROLLBACK");
+        query.op_ = kTransactionId::ROLLBACK;
+    }
+    expect_symbol(";");
+
+    return query;
+}
+
+PrepareQuery Parser::parse_prepare() {
+    // PREPARE name AS statement
+    PrepareQuery query;
+    expect_keyword("PREPARE");
+    query.name_ = expect_identifier();
+    expect_keyword("AS");
+    // the statement is parsed when it's prepared, here it only has to be made of tokens
+    const char* begin = current_.text_.data();
+    const char* end = begin;
+    while (current_.type_ != kTokenId::END) {
+        end = current_.text_.data() + current_.text_.size();
+        advance();
+    }
+    if (end == begin)
+        throw std::runtime_error{"Wrong syntax"};
+    query.statement_ = {begin, static_cast<size_t>(end - begin)};
+
+    return query;
+}
+
+ExecuteQuery Parser::parse_execute() {
+    // EXECUTE name [(value, ...)];
+    ExecuteQuery query;
+    expect_keyword("EXECUTE");
+    query.name_ = expect_identifier();
+    if (accept_symbol("(")) {
+        do {
+            query.values_.push_back(expect_value());
+        } while (accept_symbol(","));
+        expect_symbol(")");
+    }
+    expect_symbol(";");
+
+    return query;
+}
+
+DeallocateQuery Parser::parse_deallocate() {
+    // DEALLOCATE name;
+    DeallocateQuery query;
+    expect_keyword("DEALLOCATE");
+    query.name_ = expect_identifier();
+    expect_symbol(";");
+
+    return query;
+}
+
+CommandQuery Parser::parse_command() {
+    // @close, @info, @checkpoint, @save file.ext, @load file.ext, @open name [INTERVAL ms],
+    // @copy table FROM 'file.csv' [THREADS n], @threads n
+    CommandQuery query;
+    query.name_ = current_.text_;
+    advance();
+    if (query.name_ == "save" || query.name_ == "load")
+        query.args_.push_back(expect_file_name());
+    else if (query.name_ == "copy") {
+        query.args_.push_back(expect_identifier());
+        expect_keyword("FROM");
+        if (current_.type_ != kTokenId::STRING)
+            throw std::runtime_error{"Wrong syntax"};
+        query.args_.push_back(current_.text_);
+        advance();
+        if (accept_keyword("THREADS"))
+            query.args_.push_back(expect_count());
+    } else if (query.name_ == "open") {
+        query.args_.push_back(expect_identifier());
+        if (accept_keyword("INTERVAL"))
+            query.args_.push_back(expect_count());
+    } else if (query.name_ == "threads")
+        query.args_.push_back(expect_count());
+    else if (query.name_ != "close" && query.name_ != "info" && query.name_ != "checkpoint")
+        throw std::runtime_error{"Wrong syntax"};
+
+    return query;
+}
+
+// ...............CLAUSES
+
+ColumnDefinition Parser::parse_column_definition() {
+    ColumnDefinition column;
+    column.name_ = expect_identifier();
+    if (!is_keyword("int") && !is_keyword("float") && !is_keyword("double") && !is_keyword("bool") && !is_keyword("varchar"))
+        throw std::runtime_error{"Wrong syntax"};
+    column.type_ = expect_identifier();
+    if (column.type_ == "varchar" && accept_symbol("(")) {
+        for (char c : expect_count())
+            column.length_ = column.length_ * 10 + (c - '0');
+        expect_symbol(")");
+    }
+
+    return column;
+}
+
+ColumnReference Parser::parse_column_reference() {
+    // table.column
+    ColumnReference reference;
+    reference.table_ = expect_identifier();
+    expect_symbol(".");
+    reference.column_ = expect_identifier();
+
+    return reference;
+}
+
+SelectItem Parser::parse_select_item() {
+    // column or COUNT(*), COUNT|SUM|MIN|MAX|AVG(column)
+    SelectItem item;
+    item.column_ = expect_identifier();
+    if (!accept_symbol("("))
+        return item;
+    if (item.column_ == "COUNT")
+        item.function_ = kAggregateId::COUNT;
+    else if (item.column_ == "SUM")
+        item.function_ = kAggregateId::SUM;
+    else if (item.column_ == "MIN")
+        item.function_ = kAggregateId::MIN;
+    else if (item.column_ == "MAX")
+        item.function_ = kAggregateId::MAX;
+    else if (item.column_ == "AVG")
+        item.function_ = kAggregateId::AVG;
+    else
+        throw std::runtime_error{"Wrong syntax"};
+    if (item.function_ == kAggregateId::COUNT && accept_symbol("*"))
+        item.column_ = "*";
+    else
+        item.column_ = expect_identifier();
+    expect_symbol(")");
+
+    return item;
+}
+
+WhereClause Parser::parse_where() {
+    // condition {AND|OR condition}, AND binds tighter than OR
+    WhereClause where(1);
+    where.back().push_back(parse_condition());
+    while (true) {
+        if (accept_keyword("AND"))
+            where.back().push_back(parse_condition());
+        else if (accept_keyword("OR")) {
+            where.emplace_back();
+            where.back().push_back(parse_condition());
+        } else
+            break;
+    }
+
+    return where;
+}
+
+WhereCondition Parser::parse_condition() {
+    // [NOT] column op value
+    WhereCondition condition;
+    condition.not_ = accept_keyword("NOT");
+    condition.column_ = expect_identifier();
+    if (current_.type_ != kTokenId::SYMBOL ||
+        (current_.text_ != "=" && current_.text_ != "!=" && current_.text_ != ">" &&
+         current_.text_ != ">=" && current_.text_ != "<" && current_.text_ != "<="))
+        throw std::runtime_error{"Wrong syntax"};
+    condition.op_ = current_.text_;
+    advance();
+    condition.value_ = expect_value();
+
+    return condition;
+}
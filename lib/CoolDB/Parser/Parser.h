@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Lexer.h"
+#include "Query.h"
+
+// Recursive descent parser of one statement, throws std::runtime_error on wrong syntax
+class Parser final {
+private:
+    Lexer lexer_;
+    Token current_;
+    // a ? may stand for a value, the ones met so far
+    bool placeholders_;
+    std::vector<std::string_view> parameters_;
+
+    // TOKENS
+    void advance();
+    bool is_keyword(std::string_view keyword) const;
+    bool accept_keyword(std::string_view keyword);
+    void expect_keyword(std::string_view keyword);
+    bool accept_symbol(std::string_view symbol);
+    void expect_symbol(std::string_view symbol);
+    std::string_view expect_identifier();
+    std::string_view expect_value();
+    std::string_view expect_file_name();
+    std::string_view expect_count();
+    void expect_end();
+
+    // STATEMENTS
+    CreateQuery parse_create();
+    CreateIndexQuery parse_create_index();
+    InsertQuery parse_insert();
+    DropQuery parse_drop();
+    UpdateQuery parse_update();
+    DeleteQuery parse_delete();
+    SelectQuery parse_select();
+    TransactionQuery parse_transaction();
+    PrepareQuery parse_prepare();
+    ExecuteQuery parse_execute();
+    DeallocateQuery parse_deallocate();
+    CommandQuery parse_command();
+
+    // CLAUSES
+    ColumnDefinition parse_column_definition();
+    ColumnReference parse_column_reference();
+    SelectItem parse_select_item();
+    WhereClause parse_where();
+    WhereCondition parse_condition();
+public:
+    // with placeholders a ? is taken for a value, see parameters()
+    explicit Parser(std::string_view line, bool placeholders = false);
+
+    Query parse();
+    // every ? of the line in order, the values of the query that are one of them point into the line at it
+    const std::vector<std::string_view>& parameters() const;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Query AST, every name and value is a view into the parsed line
+
+struct ColumnDefinition {
+    std::string_view name_;
+    std::string_view type_;
+    // N of varchar(N), 0 if not given
+    size_t length_ = 0;
+};
+
+struct WhereCondition {
+    bool not_ = false;
+    std::string_view column_;
+    std::string_view op_;
+    std::string_view value_;
+};
+
+// OR of AND groups, empty if there's no WHERE
+using WhereClause = std::vector<std::vector<WhereCondition>>;
+
+struct CreateQuery {
+    std::string_view table_;
+    std::vector<ColumnDefinition> columns_;
+    std::vector<std::string_view> primary_key_;
+};
+
+struct CreateIndexQuery {
+    std::string_view name_;
+    std::string_view table_;
+    std::string_view column_;
+};
+
+struct InsertQuery {
+    std::string_view table_;
+    // empty if the column list is omitted
+    std::vector<std::string_view> columns_;
+    std::vector<std::vector<std::string_view>> rows_;
+};
+
+struct DropQuery {
+    std::string_view table_;
+};
+
+struct UpdateQuery {
+    std::string_view table_;
+    std::string_view column_;
+    std::string_view value_;
+    WhereClause where_;
+};
+
+struct DeleteQuery {
+    std::string_view table_;
+    WhereClause where_;
+};
+
+enum class kJoinId : uint8_t {NONE = 0, INNER = 1, LEFT = 2, RIGHT = 3};
+
+struct ColumnReference {
+    std::string_view table_;
+    std::string_view column_;
+};
+
+enum class kAggregateId : uint8_t {NONE = 0, COUNT = 1, SUM = 2, MIN = 3, MAX = 4, AVG = 5};
+
+// column or aggregate of a SELECT list
+struct SelectItem {
+    kAggregateId function_ = kAggregateId::NONE;
+    // "*" for COUNT(*)
+    std::string_view column_;
+};
+
+// key of ORDER BY
+struct OrderItem {
+    SelectItem column_;
+    bool descending_ = false;
+};
+
+struct SelectQuery {
+    // empty for SELECT *
+    std::vector<SelectItem> columns_;
+    std::string_view table_;
+    kJoinId join_ = kJoinId::NONE;
+    std::string_view join_table_;
+    ColumnReference on_[2];
+    WhereClause where_;
+    // empty if there's no GROUP BY
+    std::vector<std::string_view> group_by_;
+    // empty if there's no ORDER BY
+    std::vector<OrderItem> order_by_;
+    // nullopt if there's no LIMIT
+    std::optional<size_t> limit_;
+};
+
+enum class kTransactionId : uint8_t {BEGIN = 0, COMMIT = 1, ROLLBACK = 2};
+
+struct TransactionQuery {
+    kTransactionId op_;
+};
+
+// PREPARE name AS statement, the statement may have a ? in place of any value
+struct PrepareQuery {
+    std::string_view name_;
+    // the rest of the line
+    std::string_view statement_;
+};
+
+// EXECUTE name [(value, ...)], a value for every ? of the prepared statement
+struct ExecuteQuery {
+    std::string_view name_;
+    std::vector<std::string_view> values_;
+};
+
+struct DeallocateQuery {
+    std::string_view name_;
+};
+
+// @name args
+struct CommandQuery {
+    std::string_view name_;
+    std::vector<std::string_view> args_;
+};
+
+using Query = std::variant<CreateQuery, CreateIndexQuery, InsertQuery, DropQuery, UpdateQuery, DeleteQuery, SelectQuery,
+                           TransactionQuery, PrepareQuery, ExecuteQuery, DeallocateQuery, CommandQuery>;
@@ -0,0 +1,141 @@
+#include "Protocol.h"
+
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ...............ADDRESSES
+
+namespace {
+
+struct Address {
+    sockaddr_storage storage_{};
+    socklen_t size_ = 0;
+    bool tcp_ = false;
+};
+
+Address parse_address(const std::string& address) {
+    Address ret;
+    if (address.starts_with("unix:")) {
+        const std::string path = address.substr(5);
+        auto* un = reinterpret_cast<sockaddr_un*>(&ret.storage_);
+        if (path.empty() || path.size() >= sizeof(un->sun_path))
+            throw std::runtime_error{"Wrong socket path " + path};
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+        ret.size_ = sizeof(sockaddr_un);
+    } else if (address.starts_with("tcp:")) {
+        size_t port = 0;
+        try {
+            port = std::stoul(address.substr(4));
+        } catch (const std::exception&) {
+            port = 65536;
+        }
+        if (port > 65535)
+            throw std::runtime_error{"Wrong port " + address.substr(4)};
+        auto* in = reinterpret_cast<sockaddr_in*>(&ret.storage_);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(static_cast<uint16_t>(port));
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ret.size_ = sizeof(sockaddr_in);
+        ret.tcp_ = true;
+    } else {
+        throw std::runtime_error{"Wrong address " + address + ", expected unix:<path> or tcp:<port>"};
+    }
+    return ret;
+}
+
+}
+
+void set_no_delay(int fd) {
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+int listen_on(const std::string& address) {
+    const Address parsed = parse_address(address);
+    const int fd = ::socket(parsed.storage_.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        throw std::runtime_error{"Can't create a socket"};
+    const int one = 1;
+    if (parsed.tcp_)
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    else
+        ::unlink(reinterpret_cast<const sockaddr_un*>(&parsed.storage_)->sun_path);
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&parsed.storage_), parsed.size_) == -1 ||
+        ::listen(fd, SOMAXCONN) == -1) {
+        ::close(fd);
+        throw std::runtime_error{"Can't listen on " + address};
+    }
+    return fd;
+}
+
+int connect_to(const std::string& address) {
+    const Address parsed = parse_address(address);
+    const int fd = ::socket(parsed.storage_.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        throw std::runtime_error{"Can't create a socket"};
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&parsed.storage_), parsed.size_) == -1) {
+        ::close(fd);
+        throw std::runtime_error{"Can't connect to " + address};
+    }
+    if (parsed.tcp_)
+        set_no_delay(fd);
+    return fd;
+}
+
+// ...............FRAMES
+
+std::string frame_header(size_t size) {
+    const auto length = static_cast<uint32_t>(size);
+    return std::string(reinterpret_cast<const char*>(&length), kFrameHeader);
+}
+
+uint32_t frame_size(std::string_view bytes) {
+    uint32_t length;
+    std::memcpy(&length, bytes.data(), kFrameHeader);
+    return length;
+}
+
+static void write_all(int fd, std::string_view bytes) {
+    while (!bytes.empty()) {
+        const ssize_t written = ::send(fd, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+        if (written < 0)
+            throw std::runtime_error{"Connection lost"};
+        bytes.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+// false if the connection ends before the first byte
+static bool read_all(int fd, char* data, size_t n) {
+    for (size_t done = 0; done < n;) {
+        const ssize_t got = ::recv(fd, data + done, n - done, 0);
+        if (got == 0 && done == 0)
+            return false;
+        if (got <= 0)
+            throw std::runtime_error{"Connection lost"};
+        done += static_cast<size_t>(got);
+    }
+    return true;
+}
+
+void send_frame(int fd, std::string_view message) {
+    if (message.size() > UINT32_MAX)
+        throw std::runtime_error{"Message is too long"};
+    write_all(fd, frame_header(message.size()) + std::string(message));
+}
+
+bool receive_frame(int fd, std::string& message) {
+    char header[kFrameHeader];
+    if (!read_all(fd, header, kFrameHeader))
+        return false;
+    const uint32_t length = frame_size(std::string_view(header, kFrameHeader));
+    message.resize(length);
+    if (length != 0 && !read_all(fd, message.data(), length))
+        throw std::runtime_error{"Connection lost"};
+    return true;
+}
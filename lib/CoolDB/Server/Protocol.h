@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Messages between a client and the server, a u32 length in native byte order then that many bytes.
+// A request is one statement, its response is everything the statement printed.
+// After the response to @close the server closes the connection
+const size_t kFrameHeader = sizeof(uint32_t);
+// the server drops a connection that sends a longer statement
+const uint32_t kMaxRequest = uint32_t{64} << 20;
+
+// Addresses are unix:<path> for a Unix domain socket or tcp:<port> for localhost.
+// Both throw std::runtime_error if the socket can't be set up
+int listen_on(const std::string& address);
+int connect_to(const std::string& address);
+// small messages of a TCP socket go out at once instead of waiting for the last one to be acknowledged,
+// nothing happens to a Unix socket
+void set_no_delay(int fd);
+
+// length prefix of a message of the given size
+std::string frame_header(size_t size);
+// length of the message at the start of bytes, which holds at least kFrameHeader bytes
+uint32_t frame_size(std::string_view bytes);
+
+// blocking exchange of whole messages for clients, throw std::runtime_error on a broken connection
+void send_frame(int fd, std::string_view message);
+// false if the connection was closed before a new message
+bool receive_frame(int fd, std::string& message);
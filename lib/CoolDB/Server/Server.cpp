@@ -0,0 +1,259 @@
+#include "Server.h"
+#include "Protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// events taken from epoll at once
+const int kEvents = 64;
+// bytes read from a connection at once
+const size_t kReadBytes = size_t{1} << 16;
+
+Server::Server(CoolDB& db, const std::string& address, size_t workers) : db_(db) {
+    listen_fd_ = listen_on(address);
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event listen_event{EPOLLIN, {.u64 = kListenId}};
+    epoll_event wake_event{EPOLLIN, {.u64 = kEventId}};
+    if (epoll_fd_ == -1 || event_fd_ == -1 ||
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &listen_event) == -1 ||
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &wake_event) == -1) {
+        for (int fd : {listen_fd_, epoll_fd_, event_fd_})
+            if (fd != -1)
+                ::close(fd);
+        throw std::runtime_error{"Can't start the server"};
+    }
+    for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i)
+        workers_.emplace_back(&Server::work_loop, this);
+}
+
+Server::~Server() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_workers_ = true;
+    }
+    jobs_cv_.notify_all();
+    for (std::thread& worker : workers_)
+        worker.join();
+    for (const auto& [id, connection] : connections_)
+        ::close(connection.fd_);
+    ::close(listen_fd_);
+    ::close(epoll_fd_);
+    ::close(event_fd_);
+}
+
+void Server::stop() {
+    stop_ = true;
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = ::write(event_fd_, &one, sizeof(one));
+}
+
+// ...............WORKERS
+
+void Server::work_loop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(mutex_);
+            jobs_cv_.wait(lock, [this] { return stop_workers_ || !jobs_.empty(); });
+            if (stop_workers_)
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        std::ostringstream out;
+        bool open = true;
+        try {
+            open = db_.execute(job.statement_, out, *job.session_);
+        } catch (const std::exception& e) {
+            out << '@' << e.what() << '\n';
+        }
+        {
+            std::lock_guard lock(mutex_);
+            done_.push_back({job.connection_, std::move(out).str(), !open});
+        }
+        const uint64_t one = 1;
+        [[maybe_unused]] const ssize_t written = ::write(event_fd_, &one, sizeof(one));
+    }
+}
+
+// ...............LOOP
+
+void Server::run() {
+    epoll_event events[kEvents];
+    while (!stop_) {
+        const int n = ::epoll_wait(epoll_fd_, events, kEvents, -1);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error{"Can't wait for connections"};
+        }
+        for (int i = 0; i < n; ++i) {
+            const uint64_t id = events[i].data.u64;
+            if (id == kListenId) {
+                accept_connections();
+            } else if (id == kEventId) {
+                uint64_t count;
+                [[maybe_unused]] const ssize_t got = ::read(event_fd_, &count, sizeof(count));
+                finish_jobs();
+            } else {
+                // an earlier event of this round may have closed it
+                if (connections_.contains(id) && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                    read_from(id);
+                if (connections_.contains(id) && (events[i].events & EPOLLOUT))
+                    write_to(id);
+            }
+        }
+    }
+}
+
+void Server::accept_connections() {
+    while (true) {
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            // EAGAIN once the backlog is empty, the rest wait for the next round
+            return;
+        }
+        set_no_delay(fd);
+        const uint64_t id = next_id_++;
+        epoll_event event{EPOLLIN, {.u64 = id}};
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1) {
+            ::close(fd);
+            continue;
+        }
+        connections_[id].fd_ = fd;
+    }
+}
+
+void Server::read_from(uint64_t id) {
+    Connection& connection = connections_.at(id);
+    char buffer[kReadBytes];
+    while (true) {
+        const ssize_t got = ::recv(connection.fd_, buffer, sizeof(buffer), 0);
+        if (got > 0) {
+            connection.input_.append(buffer, static_cast<size_t>(got));
+            continue;
+        }
+        if (got == -1 && errno == EINTR)
+            continue;
+        if (got == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        // on a half closed connection only a hang up or an error wakes the loop, nothing can be sent then
+        if (got == 0 && !connection.read_closed_) {
+            // the client shut down its side, what it sent is still answered. The socket stays readable
+            // from now on, so it isn't waited on for reading any more
+            connection.read_closed_ = true;
+            epoll_event event{events_of(connection), {.u64 = id}};
+            ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd_, &event);
+            break;
+        }
+        // an error, the client is gone and an answer would go nowhere
+        close_connection(id);
+        return;
+    }
+    dispatch(id);
+    // with nothing left to run or send a half closed connection is done
+    if (connections_.contains(id) && connections_.at(id).read_closed_)
+        write_to(id);
+}
+
+void Server::write_to(uint64_t id) {
+    Connection& connection = connections_.at(id);
+    while (connection.written_ < connection.output_.size()) {
+        const ssize_t sent = ::send(connection.fd_, connection.output_.data() + connection.written_,
+                                    connection.output_.size() - connection.written_, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.written_ += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent == -1 && errno == EINTR)
+            continue;
+        if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        close_connection(id);
+        return;
+    }
+    const bool pending = connection.written_ < connection.output_.size();
+    if (!pending) {
+        connection.output_.clear();
+        connection.written_ = 0;
+    }
+    if (pending != connection.writing_) {
+        connection.writing_ = pending;
+        epoll_event event{events_of(connection), {.u64 = id}};
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd_, &event);
+    }
+    // a half closed connection is done once every whole request it sent is answered,
+    // a request it didn't finish never will be
+    const bool requests = connection.input_.size() >= kFrameHeader &&
+                          connection.input_.size() >= kFrameHeader + frame_size(connection.input_);
+    const bool done = connection.closing_ || (connection.read_closed_ && !requests);
+    if (!pending && done && !connection.busy_)
+        close_connection(id);
+}
+
+uint32_t Server::events_of(const Connection& connection) {
+    return (connection.read_closed_ ? 0u : EPOLLIN) | (connection.writing_ ? EPOLLOUT : 0u);
+}
+
+void Server::dispatch(uint64_t id) {
+    Connection& connection = connections_.at(id);
+    if (connection.busy_ || connection.closing_ || connection.input_.size() < kFrameHeader)
+        return;
+    const uint32_t size = frame_size(connection.input_);
+    if (size > kMaxRequest) {
+        connection.closing_ = true;
+        connection.input_.clear();
+        write_to(id);
+        return;
+    }
+    if (connection.input_.size() < kFrameHeader + size)
+        return;
+    Job job{id, connection.input_.substr(kFrameHeader, size), connection.session_};
+    connection.input_.erase(0, kFrameHeader + size);
+    connection.busy_ = true;
+    {
+        std::lock_guard lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    jobs_cv_.notify_one();
+}
+
+void Server::finish_jobs() {
+    std::vector<Done> done;
+    {
+        std::lock_guard lock(mutex_);
+        done.swap(done_);
+    }
+    for (Done& result : done) {
+        auto it = connections_.find(result.connection_);
+        if (it == connections_.end())
+            continue;
+        Connection& connection = it->second;
+        connection.busy_ = false;
+        connection.closing_ |= result.close_;
+        if (result.response_.size() > UINT32_MAX)
+            result.response_ = "@Result is too long\n";
+        connection.output_ += frame_header(result.response_.size());
+        connection.output_ += result.response_;
+        write_to(result.connection_);
+        if (connections_.contains(result.connection_))
+            dispatch(result.connection_);
+    }
+}
+
+void Server::close_connection(uint64_t id) {
+    auto it = connections_.find(id);
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd_, nullptr);
+    ::close(it->second.fd_);
+    connections_.erase(it);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../CoolDB.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Serves one CoolDB to many clients, see Protocol.h. The calling thread runs an epoll loop that
+// accepts connections, reads requests and writes responses, a fixed pool of workers runs the
+// statements. A connection has one statement with the workers at a time, the next ones it sent
+// wait in its buffer, so its responses come in the order of its requests
+class Server final {
+private:
+    struct Connection {
+        int fd_ = -1;
+        // bytes read and not yet taken by a request
+        std::string input_;
+        // responses, the first written_ bytes are sent
+        std::string output_;
+        size_t written_ = 0;
+        // a statement of the connection is with the workers
+        bool busy_ = false;
+        // closed once output_ is sent, after @close or a request longer than kMaxRequest
+        bool closing_ = false;
+        // the client shut down its side, e.g. after sending its last request. The requests in input_
+        // are still run, the connection is closed once the last response is sent
+        bool read_closed_ = false;
+        // EPOLLOUT is on while output_ doesn't fit in the socket
+        bool writing_ = false;
+        // the open transaction of the connection, shared with the job of its statement
+        std::shared_ptr<Session> session_ = std::make_shared<Session>();
+    };
+    struct Job {
+        uint64_t connection_;
+        std::string statement_;
+        std::shared_ptr<Session> session_;
+    };
+    struct Done {
+        uint64_t connection_;
+        std::string response_;
+        bool close_;
+    };
+
+    // epoll data of the two descriptors that aren't connections, connections count from kFirstConnection
+    static constexpr uint64_t kListenId = 0;
+    static constexpr uint64_t kEventId = 1;
+    static constexpr uint64_t kFirstConnection = 2;
+
+    CoolDB& db_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    // wakes the loop when a job is done or stop() is called
+    int event_fd_ = -1;
+    std::unordered_map<uint64_t, Connection> connections_;
+    uint64_t next_id_ = kFirstConnection;
+
+    std::mutex mutex_;
+    std::condition_variable jobs_cv_;
+    std::deque<Job> jobs_;
+    std::vector<Done> done_;
+    bool stop_workers_ = false;
+    std::atomic<bool> stop_ = false;
+    std::vector<std::thread> workers_;
+
+    void work_loop();
+
+    // LOOP
+    void accept_connections();
+    void read_from(uint64_t id);
+    void write_to(uint64_t id);
+    // the epoll events to wait for on the connection
+    static uint32_t events_of(const Connection& connection);
+    // hands the next whole request of the connection to the workers if it has none there
+    void dispatch(uint64_t id);
+    void finish_jobs();
+    void close_connection(uint64_t id);
+public:
+    // throws std::runtime_error if address can't be listened on
+    Server(CoolDB& db, const std::string& address, size_t workers);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // serves until stop(), a statement that runs then is finished first
+    void run();
+    // safe from any thread and from a signal handler
+    void stop();
+};
@@ -0,0 +1,105 @@
+#include "Statement.h"
+#include "Parser/Lexer.h"
+#include "Parser/Parser.h"
+
+#include <algorithm>
+
+// calls f on every value of query, in the order of the text
+template <typename F>
+static void for_each_value(Query& query, F f) {
+    auto where = [&f](WhereClause& clause) {
+        for (std::vector<WhereCondition>& group : clause)
+            for (WhereCondition& condition : group)
+                f(condition.value_);
+    };
+    if (auto insert = std::get_if<InsertQuery>(&query)) {
+        for (std::vector<std::string_view>& row : insert->rows_)
+            for (std::string_view& value : row)
+                f(value);
+    } else if (auto update = std::get_if<UpdateQuery>(&query)) {
+        f(update->value_);
+        where(update->where_);
+    } else if (auto remove = std::get_if<DeleteQuery>(&query)) {
+        where(remove->where_);
+    } else if (auto select = std::get_if<SelectQuery>(&query)) {
+        where(select->where_);
+    }
+}
+
+Statement::Statement(std::string text) : text_(std::move(text)) {
+    Parser parser(text_, true);
+    query_ = parser.parse();
+    for (std::string_view parameter : parser.parameters())
+        parameters_.push_back(parameter.data());
+}
+
+const Query& Statement::query() const { return query_; }
+
+size_t Statement::parameters() const { return parameters_.size(); }
+
+size_t Statement::parameter(std::string_view value) const {
+    // the parser meets the ? in the order of the text
+    auto it = std::lower_bound(parameters_.begin(), parameters_.end(), value.data(), std::less<>());
+    return it != parameters_.end() && *it == value.data() ? static_cast<size_t>(it - parameters_.begin())
+                                                          : static_cast<size_t>(-1);
+}
+
+Query Statement::bind(const std::vector<std::string_view>& values) const {
+    Query ret = query_;
+    for_each_value(ret, [this, &values](std::string_view& value) {
+        size_t ind = parameter(value);
+        if (ind != static_cast<size_t>(-1))
+            value = values[ind];
+    });
+    return ret;
+}
+
+std::string Statement::text(const std::vector<std::string_view>& values) const {
+    // a value is quoted whatever it was, the parser gives the same view of 5 and '5'
+    std::string ret;
+    size_t pos = 0;
+    for (size_t i = 0; i < parameters_.size(); ++i) {
+        const size_t at = parameters_[i] - text_.data();
+        ret.append(text_, pos, at - pos);
+        ret += '\'';
+        ret += values[i];
+        ret += '\'';
+        pos = at + 1;
+    }
+    ret.append(text_, pos);
+    return ret;
+}
+
+std::shared_ptr<const SelectPlan> Statement::plan() const { return plan_.load(); }
+
+void Statement::set_plan(std::shared_ptr<const SelectPlan> plan) const { plan_.store(std::move(plan)); }
+
+std::string Statement::normalize(std::string_view line, std::vector<std::string_view>& values) {
+    Lexer lexer(line);
+    Token token = lexer.next();
+    if (token.type_ != kTokenId::IDENTIFIER || token.text_ != "SELECT")
+        return {};
+    std::string ret;
+    ret.reserve(line.size());
+    bool limit = false;
+    for (; token.type_ != kTokenId::END; token = lexer.next()) {
+        if (token.type_ == kTokenId::ERROR || token.type_ == kTokenId::COMMAND ||
+            (token.type_ == kTokenId::SYMBOL && token.text_ == "?"))
+            return {};
+        if (!ret.empty())
+            ret += ' ';
+        // the count of LIMIT isn't a value, it stays in the text
+        if ((token.type_ == kTokenId::NUMBER || token.type_ == kTokenId::STRING) && !limit) {
+            ret += '?';
+            values.push_back(token.text_);
+        } else if (token.type_ == kTokenId::STRING) {
+            ret += '\'';
+            ret += token.text_;
+            ret += '\'';
+        } else {
+            ret += token.text_;
+        }
+        limit = token.type_ == kTokenId::IDENTIFIER && token.text_ == "LIMIT";
+    }
+    return ret;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Executor/Aggregate.h"
+#include "Executor/Sort.h"
+#include "Parser/Query.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// condition of a WHERE with its column found, its value is typed when the statement runs
+struct PlannedCondition {
+    // the AND group it belongs to
+    size_t group_;
+    bool not_;
+    // -1 if the input has no column name_, the WHERE stops at this condition then
+    size_t column_;
+    uint8_t op_;
+    kTypeId type_;
+    std::string_view name_;
+    // the value written in the statement, unless parameter_ is the number of the ? that stands for it
+    std::string_view value_;
+    size_t parameter_;
+};
+
+// A SELECT with every name resolved against the columns of its tables: what the operators of the pipeline are
+// made of, not the operators, which point into one version of the tables. Valid while the tables keep the
+// schemas it was made for
+struct SelectPlan {
+    uint64_t schema_[2] = {};
+    // key columns of the join in the table and in the join table; RIGHT JOIN hashes the table, the others
+    // hash the join table
+    size_t join_columns_[2] = {};
+    std::vector<PlannedCondition> where_;
+    bool aggregated_ = false;
+    std::vector<size_t> key_columns_;
+    std::vector<AggregateColumn> aggregates_;
+    std::vector<SortColumn> sort_columns_;
+    std::vector<size_t> column_indexes_;
+};
+
+// A statement parsed once and run many times, each time with a value for every ? of its text.
+// A SELECT also keeps the plan it was last run with. Safe to share between threads
+class Statement final {
+private:
+    std::string text_;
+    // points into text_
+    Query query_;
+    // every ? of text_ in order
+    std::vector<const char*> parameters_;
+    mutable std::atomic<std::shared_ptr<const SelectPlan>> plan_;
+public:
+    // throws std::runtime_error on wrong syntax
+    explicit Statement(std::string text);
+
+    const Query& query() const;
+    size_t parameters() const;
+    // the number of the ? that a value of query() is, -1 for a value written in the text
+    size_t parameter(std::string_view value) const;
+    // query() with values in place of the ?, it points into the text and into values
+    Query bind(const std::vector<std::string_view>& values) const;
+    // the text with values in place of the ?, a statement of its own
+    std::string text(const std::vector<std::string_view>& values) const;
+
+    std::shared_ptr<const SelectPlan> plan() const;
+    void set_plan(std::shared_ptr<const SelectPlan> plan) const;
+
+    // The text of a SELECT with every value of line written as ?, so the SELECTs that differ only in
+    // their values have the same text; values gets those values. Empty for any other statement
+    // and for a line the parser would refuse anyway
+    static std::string normalize(std::string_view line, std::vector<std::string_view>& values);
+};
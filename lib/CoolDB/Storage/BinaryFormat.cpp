@@ -0,0 +1,347 @@
+#include "BinaryFormat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static size_t aligned(size_t n) { return (n + 7) / 8 * 8; }
+
+// ...............WRITE
+
+namespace {
+
+class Writer final {
+private:
+    std::ofstream file_;
+    size_t pos_ = 0;
+public:
+    explicit Writer(const std::string& path) : file_(path, std::ios::binary) {
+        if (!file_.is_open())
+            throw std::runtime_error{"Can't open the file"};
+    }
+
+    void bytes(const void* data, size_t n) {
+        file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(n));
+        pos_ += n;
+    }
+
+    void u64(uint64_t x) { bytes(&x, sizeof(x)); }
+
+    void align() {
+        static const char kZeros[8] = {};
+        bytes(kZeros, aligned(pos_) - pos_);
+    }
+
+    void string(const std::string& s) {
+        u64(s.size());
+        bytes(s.data(), s.size());
+        align();
+    }
+
+    void finish() {
+        file_.close();
+        if (file_.fail())
+            throw std::runtime_error{"Can't write the file"};
+    }
+};
+
+} // namespace
+
+// (n + 1) offsets, then the heap of the n strings
+template<class Strings>
+static void write_strings(Writer& writer, size_t n, const Strings& strings) {
+    std::vector<uint64_t> offsets(n + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+        offsets[i + 1] = offsets[i] + strings(i).size();
+    writer.bytes(offsets.data(), offsets.size() * sizeof(uint64_t));
+    for (size_t i = 0; i < n; ++i)
+        writer.bytes(strings(i).data(), strings(i).size());
+}
+
+// the cells of a column one chunk at a time, the file has them contiguous
+template<class V>
+static void write_cells(Writer& writer, size_t n, const V& values) {
+    for (size_t begin = 0; begin < n; begin += kChunkRows)
+        writer.bytes(values.data(begin), std::min(kChunkRows, n - begin) * sizeof(typename V::value_type));
+}
+
+static void write_column(Writer& writer, const Column& column) {
+    // a chunk starts at a word, the words of the chunks make the whole null bitmap
+    for (size_t begin = 0; begin < column.size(); begin += kChunkRows) {
+        const size_t rows = std::min(kChunkRows, column.size() - begin);
+        writer.bytes(column.null_words(begin), (rows + Bitmap::kWordBits - 1) / Bitmap::kWordBits * sizeof(uint64_t));
+    }
+    switch (column.type()) {
+        case kTypeId::INT:
+            write_cells(writer, column.size(), column.values<int32_t>());
+            break;
+        case kTypeId::FLOAT:
+            write_cells(writer, column.size(), column.values<float>());
+            break;
+        case kTypeId::DOUBLE:
+            write_cells(writer, column.size(), column.values<double>());
+            break;
+        case kTypeId::BOOL:
+            write_cells(writer, column.size(), column.values<uint8_t>());
+            break;
+        case kTypeId::STRING: {
+            if (!column.encoded()) {
+                writer.u64(kPlainStrings);
+                const Column::Reader<std::string> values = column.values<std::string>();
+                write_strings(writer, values.size(), [&values](size_t i) -> const std::string& { return values[i]; });
+                break;
+            }
+            const Dictionary& dictionary = column.dictionary();
+            writer.u64(dictionary.size());
+            write_strings(writer, dictionary.size(),
+                          [&dictionary](size_t i) -> const std::string& { return dictionary[i]; });
+            writer.align();
+            write_cells(writer, column.size(), column.codes());
+            break;
+        }
+        case kTypeId::NULLOBJ:
+            break;
+    }
+    writer.align();
+}
+
+void write_binary(const std::string& path, const std::vector<const Table*>& tables, uint32_t checkpoint) {
+    Writer writer(path);
+    writer.bytes(kBinaryMagic, sizeof(kBinaryMagic));
+    const uint32_t header[2] = {kBinaryVersion, checkpoint};
+    writer.bytes(header, sizeof(header));
+    writer.u64(tables.size());
+
+    for (const Table* table : tables) {
+        const size_t number_of_columns = table->size().first;
+        writer.string(table->name());
+        writer.u64(number_of_columns);
+        writer.u64(table->size().second);
+        for (size_t i = 0; i < number_of_columns; ++i) {
+            writer.u64(static_cast<uint64_t>(table->get_types()[i]));
+            writer.string(table->get_names()[i]);
+            writer.u64(table->get_lengths()[i]);
+        }
+        std::vector<size_t> primary_keys(table->get_primary_keys().begin(), table->get_primary_keys().end());
+        std::sort(primary_keys.begin(), primary_keys.end());
+        writer.u64(primary_keys.size());
+        for (size_t x : primary_keys)
+            writer.u64(x);
+        writer.u64(table->get_indexes().size());
+        for (const OrderedIndex& index : table->get_indexes()) {
+            writer.string(index.name());
+            writer.u64(index.column());
+        }
+
+        for (size_t i = 0; i < number_of_columns; ++i)
+            write_column(writer, table->get_column(i));
+    }
+    writer.finish();
+}
+
+// ...............READ
+
+namespace {
+
+// bounds checked cursor over the mapping
+class Reader final {
+private:
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+public:
+    Reader(const char* data, size_t size) : begin_(data), pos_(data), end_(data + size) {}
+
+    const char* take(size_t n) {
+        if (static_cast<size_t>(end_ - pos_) < n)
+            throw std::runtime_error{"Corrupted file"};
+        const char* ret = pos_;
+        pos_ += n;
+        return ret;
+    }
+
+    size_t remaining() const { return end_ - pos_; }
+
+    uint64_t u64() {
+        uint64_t x;
+        std::memcpy(&x, take(sizeof(x)), sizeof(x));
+        return x;
+    }
+
+    void align() { take(aligned(pos_ - begin_) - static_cast<size_t>(pos_ - begin_)); }
+
+    std::string string() {
+        const uint64_t n = u64();
+        std::string ret(take(n), n);
+        align();
+        return ret;
+    }
+};
+
+} // namespace
+
+template<class T>
+static std::vector<T> read_values(Reader& reader, size_t rows) {
+    // rows is already checked against the file size, so the product can't overflow
+    const char* data = reader.take(rows * sizeof(T));
+    std::vector<T> ret(rows);
+    std::memcpy(ret.data(), data, rows * sizeof(T));
+    return ret;
+}
+
+// n strings stored as (n + 1) offsets and a heap
+static std::vector<std::string> read_strings(Reader& reader, size_t n) {
+    if (n >= reader.remaining() / sizeof(uint64_t))
+        throw std::runtime_error{"Corrupted file"};
+    const std::vector<uint64_t> offsets = read_values<uint64_t>(reader, n + 1);
+    if (offsets[0] != 0)
+        throw std::runtime_error{"Corrupted file"};
+    const char* heap = reader.take(offsets[n]);
+    std::vector<std::string> values;
+    values.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (offsets[i + 1] < offsets[i])
+            throw std::runtime_error{"Corrupted file"};
+        values.emplace_back(heap + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    return values;
+}
+
+static Column read_column(Reader& reader, kTypeId type, size_t rows, uint32_t version) {
+    // every column stores at least its null bitmap
+    if (rows / Bitmap::kWordBits >= reader.remaining())
+        throw std::runtime_error{"Corrupted file"};
+    const char* words = reader.take((rows + Bitmap::kWordBits - 1) / Bitmap::kWordBits * sizeof(uint64_t));
+    Bitmap nulls(rows);
+    std::memcpy(nulls.data(), words, nulls.words() * sizeof(uint64_t));
+    if (rows % Bitmap::kWordBits != 0)
+        nulls.data()[nulls.words() - 1] &= (uint64_t{1} << (rows % Bitmap::kWordBits)) - 1;
+
+    columndata data;
+    switch (type) {
+        case kTypeId::INT:
+            data = read_values<int32_t>(reader, rows);
+            break;
+        case kTypeId::FLOAT:
+            data = read_values<float>(reader, rows);
+            break;
+        case kTypeId::DOUBLE:
+            data = read_values<double>(reader, rows);
+            break;
+        case kTypeId::BOOL:
+            data = read_values<uint8_t>(reader, rows);
+            break;
+        case kTypeId::STRING: {
+            const uint64_t dictionary_size = version >= 3 ? reader.u64() : kPlainStrings;
+            if (dictionary_size == kPlainStrings) {
+                data = read_strings(reader, rows);
+                break;
+            }
+            auto dictionary = std::make_shared<Dictionary>();
+            for (const std::string& s : read_strings(reader, dictionary_size))
+                if (dictionary->insert(s) + 1 != dictionary->size())
+                    throw std::runtime_error{"Corrupted file"};
+            reader.align();
+            std::vector<uint32_t> codes = read_values<uint32_t>(reader, rows);
+            for (size_t i = 0; i < rows; ++i) {
+                if (nulls[i])
+                    codes[i] = 0;
+                else if (codes[i] >= dictionary->size())
+                    throw std::runtime_error{"Corrupted file"};
+            }
+            reader.align();
+            Column ret(type);
+            ret.assign(std::move(dictionary), std::move(codes), std::move(nulls));
+            return ret;
+        }
+        case kTypeId::NULLOBJ:
+            data = std::vector<Null>(rows);
+            break;
+    }
+    reader.align();
+
+    Column ret(type);
+    ret.assign(std::move(data), std::move(nulls));
+    return ret;
+}
+
+static Table* read_table(Reader& reader, uint32_t version) {
+    auto table = new Table(reader.string());
+    try {
+        const size_t number_of_columns = reader.u64();
+        const size_t number_of_rows = reader.u64();
+        for (size_t i = 0; i < number_of_columns; ++i) {
+            const uint64_t type = reader.u64();
+            if (type > static_cast<uint64_t>(kTypeId::NULLOBJ))
+                throw std::runtime_error{"Corrupted file"};
+            std::string name = reader.string();
+            const size_t length = version >= 4 ? reader.u64() : 0;
+            table->add_column(static_cast<kTypeId>(type), name, length);
+        }
+        const size_t primary_key_columns = reader.u64();
+        for (size_t i = 0; i < primary_key_columns; ++i) {
+            const size_t col_num = reader.u64();
+            if (col_num >= number_of_columns)
+                throw std::runtime_error{"Corrupted file"};
+            table->add_primary_index(col_num);
+        }
+        std::vector<std::pair<std::string, size_t>> indexes;
+        const size_t number_of_indexes = version >= 2 ? reader.u64() : 0;
+        for (size_t i = 0; i < number_of_indexes; ++i) {
+            std::string name = reader.string();
+            const size_t col_num = reader.u64();
+            if (col_num >= number_of_columns)
+                throw std::runtime_error{"Corrupted file"};
+            indexes.emplace_back(std::move(name), col_num);
+        }
+
+        std::vector<Column> columns;
+        columns.reserve(number_of_columns);
+        for (size_t i = 0; i < number_of_columns; ++i)
+            columns.push_back(read_column(reader, table->get_types()[i], number_of_rows, version));
+        table->insert_columns(std::move(columns));
+        // built once from the loaded columns
+        for (const auto& [name, col_num] : indexes)
+            table->add_index(name, col_num);
+    } catch (...) {
+        delete table;
+        throw;
+    }
+
+    return table;
+}
+
+bool is_binary_file(const MappedFile& file) {
+    return file.size() >= sizeof(kBinaryMagic) && std::memcmp(file.data(), kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+}
+
+uint32_t read_checkpoint(const MappedFile& file) {
+    Reader reader(file.data(), file.size());
+    reader.take(sizeof(kBinaryMagic));
+    uint32_t header[2];
+    std::memcpy(header, reader.take(sizeof(header)), sizeof(header));
+    return header[1];
+}
+
+std::vector<Table*> read_binary(const MappedFile& file) {
+    Reader reader(file.data(), file.size());
+    reader.take(sizeof(kBinaryMagic));
+    uint32_t header[2];
+    std::memcpy(header, reader.take(sizeof(header)), sizeof(header));
+    if (header[0] == 0 || header[0] > kBinaryVersion)
+        throw std::runtime_error{"Unsupported file version"};
+
+    std::vector<Table*> ret;
+    try {
+        const size_t number_of_tables = reader.u64();
+        for (size_t i = 0; i < number_of_tables; ++i)
+            ret.push_back(read_table(reader, header[0]));
+    } catch (...) {
+        for (Table* table : ret)
+            delete table;
+        throw;
+    }
+
+    return ret;
+}
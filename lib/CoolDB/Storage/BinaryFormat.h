@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../Table/Table.h"
+#include "MappedFile.h"
+
+// Binary database file, native byte order, every section starts at a multiple of 8 bytes:
+//   header:  magic "COOLDB\0\0", u32 version, u32 checkpoint, u64 number of tables
+//   table:   string name, u64 columns, u64 rows, columns x (u64 type, string name),
+//            since version 4 each with a u64 varchar(N) length after the name, 0 if there's none,
+//            u64 primary key columns, that many u64 column indexes,
+//            since version 2: u64 ordered indexes, that many (string name, u64 column index)
+//   column:  null bitmap of (rows + 63) / 64 u64 words, then the values:
+//            int/float - rows x 4 bytes, double - rows x 8, bool - rows x 1,
+//            varchar - (rows + 1) x u64 offsets into the string heap that follows,
+//            since version 3 after a u64 dictionary size, kPlainStrings for a column that isn't encoded.
+//            An encoded one stores its dictionary as (size + 1) offsets and a heap, then rows x u32 codes
+//   string:  u64 length, bytes
+const char kBinaryMagic[8] = {'C', 'O', 'O', 'L', 'D', 'B', '\0', '\0'};
+const uint32_t kBinaryVersion = 4;
+const uint64_t kPlainStrings = static_cast<uint64_t>(-1);
+
+bool is_binary_file(const MappedFile& file);
+
+// checkpoint numbers the write-ahead log that continues the file, 0 if there's none
+void write_binary(const std::string& path, const std::vector<const Table*>& tables, uint32_t checkpoint = 0);
+uint32_t read_checkpoint(const MappedFile& file);
+
+// new tables owned by the caller, throws std::runtime_error on a broken file
+std::vector<Table*> read_binary(const MappedFile& file);
@@ -0,0 +1,224 @@
+#include "CsvLoader.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+// smaller files are not worth splitting between threads
+const size_t kMinChunkBytes = size_t{1} << 20;
+
+static columndata empty_data(kTypeId type) {
+    switch (type) {
+        case kTypeId::INT:
+            return std::vector<int32_t>{};
+        case kTypeId::FLOAT:
+            return std::vector<float>{};
+        case kTypeId::DOUBLE:
+            return std::vector<double>{};
+        case kTypeId::BOOL:
+            return std::vector<uint8_t>{};
+        case kTypeId::STRING:
+            return std::vector<std::string>{};
+        default:
+            return std::vector<Null>{};
+    }
+}
+
+template<class T>
+static void append_number(columndata& data, std::string_view field) {
+    T x{};
+    auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), x);
+    if (ec != std::errc() || ptr != field.data() + field.size())
+        throw std::runtime_error{"Wrong value " + std::string(field)};
+    std::get<std::vector<T>>(data).push_back(x);
+}
+
+static void append_field(columndata& data, Bitmap& nulls, kTypeId type, std::string_view field, bool quoted) {
+    if ((field.empty() && !quoted) || type == kTypeId::NULLOBJ) {
+        std::visit([](auto& values) { values.emplace_back(); }, data);
+        nulls.push_back(true);
+        return;
+    }
+    switch (type) {
+        case kTypeId::INT:
+            append_number<int32_t>(data, field);
+            break;
+        case kTypeId::FLOAT:
+            append_number<float>(data, field);
+            break;
+        case kTypeId::DOUBLE:
+            append_number<double>(data, field);
+            break;
+        case kTypeId::BOOL:
+            if (field != "true" && field != "false" && field != "1" && field != "0")
+                throw std::runtime_error{"Wrong value " + std::string(field)};
+            std::get<std::vector<uint8_t>>(data).push_back(field == "true" || field == "1");
+            break;
+        case kTypeId::STRING:
+            std::get<std::vector<std::string>>(data).emplace_back(field);
+            break;
+        default:
+            break;
+    }
+    nulls.push_back(false);
+}
+
+// varchar cells parsed straight into codes while the column has few distinct strings, see kDictionaryFraction
+struct StringCodes {
+    std::shared_ptr<Dictionary> dictionary_;
+    std::vector<uint32_t> codes_;
+
+    // the strings of the codes parsed so far go to data, which gets the rest of the column
+    void decode(columndata& data, const Bitmap& nulls) {
+        auto& values = std::get<std::vector<std::string>>(data);
+        for (size_t i = 0; i < codes_.size(); ++i)
+            values.emplace_back(nulls[i] ? std::string() : (*dictionary_)[codes_[i]]);
+        dictionary_.reset();
+        std::vector<uint32_t>().swap(codes_);
+    }
+};
+
+// parses whole lines of [pos, end) into new columns of the given types
+static std::vector<Column> parse_chunk(const char* pos, const char* end, const std::vector<kTypeId>& types) {
+    // one row per line is a tight upper bound, so the columns never reallocate
+    const size_t lines = std::count(pos, end, '\n') + 1;
+    std::vector<columndata> data;
+    std::vector<Bitmap> nulls(types.size());
+    std::vector<StringCodes> strings(types.size());
+    for (size_t c = 0; c < types.size(); ++c) {
+        data.push_back(empty_data(types[c]));
+        nulls[c].reserve(lines);
+        if (types[c] == kTypeId::STRING) {
+            strings[c].dictionary_ = std::make_shared<Dictionary>();
+            strings[c].codes_.reserve(lines);
+        } else {
+            std::visit([lines](auto& values) { values.reserve(lines); }, data[c]);
+        }
+    }
+    std::string unescaped;
+
+    while (pos < end && !types.empty()) {
+        // empty lines
+        if (*pos == '\n' || (*pos == '\r' && pos + 1 < end && pos[1] == '\n')) {
+            pos += *pos == '\r' ? 2 : 1;
+            continue;
+        }
+        for (size_t c = 0; c < types.size(); ++c) {
+            std::string_view field;
+            const bool quoted = pos < end && *pos == '"';
+            if (quoted) {
+                const char* start = ++pos;
+                bool escaped = false;
+                while (true) {
+                    if (pos >= end)
+                        throw std::runtime_error{"Quote is not closed"};
+                    if (*pos == '"') {
+                        if (pos + 1 < end && pos[1] == '"') {
+                            escaped = true;
+                            pos += 2;
+                            continue;
+                        }
+                        break;
+                    }
+                    ++pos;
+                }
+                field = {start, static_cast<size_t>(pos - start)};
+                ++pos;
+                if (escaped) {
+                    unescaped.clear();
+                    for (size_t i = 0; i < field.size(); ++i) {
+                        unescaped.push_back(field[i]);
+                        i += field[i] == '"';
+                    }
+                    field = unescaped;
+                }
+            } else {
+                const char* start = pos;
+                while (pos < end && *pos != ',' && *pos != '\n')
+                    ++pos;
+                field = {start, static_cast<size_t>(pos - start)};
+                if (!field.empty() && field.back() == '\r')
+                    field.remove_suffix(1);
+            }
+
+            if (c + 1 < types.size()) {
+                if (pos >= end || *pos != ',')
+                    throw std::runtime_error{"Column count doesn't match value count"};
+                ++pos;
+            } else {
+                if (pos < end && *pos == '\r')
+                    ++pos;
+                if (pos < end && *pos != '\n')
+                    throw std::runtime_error{"Column count doesn't match value count"};
+                pos += pos < end;
+            }
+            if (strings[c].dictionary_ == nullptr) {
+                append_field(data[c], nulls[c], types[c], field, quoted);
+                continue;
+            }
+            const bool null = field.empty() && !quoted;
+            strings[c].codes_.push_back(null ? 0 : strings[c].dictionary_->insert(field));
+            nulls[c].push_back(null);
+            if (dictionary_overflows(strings[c].dictionary_->size(), strings[c].codes_.size(), lines / kDictionaryFraction)) {
+                std::get<std::vector<std::string>>(data[c]).reserve(lines);
+                strings[c].decode(data[c], nulls[c]);
+            }
+        }
+    }
+
+    std::vector<Column> ret;
+    ret.reserve(types.size());
+    for (size_t c = 0; c < types.size(); ++c) {
+        ret.emplace_back(types[c]);
+        if (strings[c].dictionary_ != nullptr)
+            ret.back().assign(std::move(strings[c].dictionary_), std::move(strings[c].codes_), std::move(nulls[c]));
+        else
+            ret.back().assign(std::move(data[c]), std::move(nulls[c]));
+    }
+    return ret;
+}
+
+void copy_csv(Table* table, const std::string& path, size_t threads) {
+    MappedFile file(path);
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    const std::vector<kTypeId>& types = table->get_types();
+
+    threads = std::max<size_t>(1, std::min(threads, file.size() / kMinChunkBytes));
+    std::vector<const char*> bounds{begin};
+    for (size_t k = 1; k < threads; ++k) {
+        const char* pos = std::max(bounds.back(), begin + file.size() / threads * k);
+        const void* line_end = std::memchr(pos, '\n', end - pos);
+        bounds.push_back(line_end == nullptr ? end : static_cast<const char*>(line_end) + 1);
+    }
+    bounds.push_back(end);
+
+    std::vector<std::vector<Column>> parts(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    auto work = [&](size_t k) {
+        try {
+            parts[k] = parse_chunk(bounds[k], bounds[k + 1], types);
+        } catch (...) {
+            errors[k] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t k = 1; k < threads; ++k)
+        workers.emplace_back(work, k);
+    work(0);
+    for (std::thread& worker : workers)
+        worker.join();
+    for (const std::exception_ptr& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+
+    std::vector<Column> columns = std::move(parts[0]);
+    for (size_t k = 1; k < threads; ++k)
+        for (size_t c = 0; c < columns.size(); ++c)
+            columns[c].append(std::move(parts[k][c]));
+    table->append_columns(std::move(columns));
+}
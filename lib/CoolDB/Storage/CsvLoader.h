@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../Table/Table.h"
+
+// Appends the rows of a CSV file to table, nothing is appended if a line or a primary key is wrong.
+// Fields are separated by ',', an empty field is NULL, "quoted" fields may hold ',' and "" for a quote.
+// With threads > 1 the file is split into line aligned chunks parsed in parallel,
+// so quoted fields must not hold line breaks in that mode
+void copy_csv(Table* table, const std::string& path, size_t threads = 1);
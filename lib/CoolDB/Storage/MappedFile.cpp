@@ -0,0 +1,40 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error{"Can't open the file"};
+    struct stat info{};
+    if (::fstat(fd, &info) == -1) {
+        ::close(fd);
+        throw std::runtime_error{"Can't open the file"};
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ != 0) {
+        void* map = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error{"Can't open the file"};
+        }
+        // the loader reads the file front to back exactly once
+        ::madvise(map, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(map);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr)
+        ::munmap(const_cast<char*>(data_), size_);
+}
+
+const char* MappedFile::data() const { return data_; }
+
+size_t MappedFile::size() const { return size_; }
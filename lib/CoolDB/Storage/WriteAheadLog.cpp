@@ -0,0 +1,205 @@
+#include "WriteAheadLog.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char kWalMagic[8] = {'C', 'O', 'O', 'L', 'W', 'A', 'L', '\0'};
+const size_t kWalHeaderSize = sizeof(kWalMagic) + 2 * sizeof(uint32_t);
+const size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+
+static uint32_t fnv1a(std::string_view bytes) {
+    uint32_t hash = 2166136261u;
+    for (char c : bytes) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void write_all(int fd, const char* data, size_t n) {
+    while (n != 0) {
+        const ssize_t written = ::write(fd, data, n);
+        if (written < 0)
+            throw std::runtime_error{"Can't write the log"};
+        data += written;
+        n -= static_cast<size_t>(written);
+    }
+}
+
+// ...............FILES
+
+void sync_file(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1 || ::fsync(fd) == -1) {
+        if (fd != -1)
+            ::close(fd);
+        throw std::runtime_error{"Can't sync " + path};
+    }
+    ::close(fd);
+}
+
+void replace_file(const std::string& from, const std::string& to) {
+    if (::rename(from.c_str(), to.c_str()) == -1)
+        throw std::runtime_error{"Can't replace " + to};
+    // the rename itself lives in the directory
+    const size_t slash = to.rfind('/');
+    sync_file(slash == std::string::npos ? "." : to.substr(0, slash + 1));
+}
+
+// ...............OPEN
+
+WriteAheadLog::WriteAheadLog(const std::string& path, uint32_t checkpoint, std::chrono::milliseconds flush_interval)
+        : path_(path), checkpoint_(checkpoint), flush_interval_(flush_interval) {
+    size_t valid = 0;
+    if (::access(path.c_str(), F_OK) == 0) {
+        MappedFile file(path);
+        uint32_t header[2];
+        if (file.size() >= kWalHeaderSize && std::memcmp(file.data(), kWalMagic, sizeof(kWalMagic)) == 0) {
+            std::memcpy(header, file.data() + sizeof(kWalMagic), sizeof(header));
+            // a log of an older checkpoint is already in the snapshot
+            if (header[0] == checkpoint)
+                valid = kWalHeaderSize;
+        }
+        while (valid != 0 && file.size() - valid >= kRecordHeaderSize) {
+            uint32_t record[2];
+            std::memcpy(record, file.data() + valid, sizeof(record));
+            if (file.size() - valid - kRecordHeaderSize < record[0])
+                break;
+            std::string_view bytes(file.data() + valid + kRecordHeaderSize, record[0]);
+            if (fnv1a(bytes) != record[1])
+                break;
+            recovered_.emplace_back(bytes);
+            valid += kRecordHeaderSize + record[0];
+        }
+    }
+
+    if (valid == 0)
+        create(checkpoint);
+    else {
+        // cut a record torn by a crash, new records go right after the last whole one
+        fd_ = ::open(path.c_str(), O_WRONLY);
+        if (fd_ == -1 || ::ftruncate(fd_, static_cast<off_t>(valid)) == -1 ||
+            ::lseek(fd_, 0, SEEK_END) == -1)
+            throw std::runtime_error{"Can't open the log"};
+        size_ = valid;
+    }
+    flusher_ = std::thread(&WriteAheadLog::flush_loop, this);
+}
+
+void WriteAheadLog::create(uint32_t checkpoint) {
+    const std::string temp = path_ + ".tmp";
+    const int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        throw std::runtime_error{"Can't open the log"};
+    char header[kWalHeaderSize] = {};
+    std::memcpy(header, kWalMagic, sizeof(kWalMagic));
+    std::memcpy(header + sizeof(kWalMagic), &checkpoint, sizeof(checkpoint));
+    try {
+        write_all(fd, header, sizeof(header));
+        if (::fsync(fd) == -1)
+            throw std::runtime_error{"Can't write the log"};
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    replace_file(temp, path_);
+
+    if (fd_ != -1)
+        ::close(fd_);
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_APPEND);
+    if (fd_ == -1)
+        throw std::runtime_error{"Can't open the log"};
+    checkpoint_ = checkpoint;
+    size_ = kWalHeaderSize;
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    pending_cv_.notify_all();
+    flusher_.join();
+    if (fd_ != -1)
+        ::close(fd_);
+}
+
+std::vector<std::string> WriteAheadLog::take_recovered() { return std::move(recovered_); }
+
+uint32_t WriteAheadLog::checkpoint() const { return checkpoint_; }
+
+size_t WriteAheadLog::size() {
+    std::lock_guard lock(mutex_);
+    return size_;
+}
+
+// ...............COMMIT
+
+uint64_t WriteAheadLog::append(std::string_view record) {
+    const uint32_t header[2] = {static_cast<uint32_t>(record.size()), fnv1a(record)};
+    uint64_t lsn;
+    {
+        std::lock_guard lock(mutex_);
+        buffer_.append(reinterpret_cast<const char*>(header), sizeof(header));
+        buffer_.append(record);
+        size_ += sizeof(header) + record.size();
+        lsn = ++appended_;
+    }
+    pending_cv_.notify_one();
+    return lsn;
+}
+
+void WriteAheadLog::wait(uint64_t lsn) {
+    std::unique_lock lock(mutex_);
+    durable_cv_.wait(lock, [this, lsn] { return durable_ >= lsn || failed_; });
+    if (durable_ < lsn)
+        throw std::runtime_error{"Can't write the log"};
+}
+
+void WriteAheadLog::commit(std::string_view record) { wait(append(record)); }
+
+void WriteAheadLog::flush_loop() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        pending_cv_.wait(lock, [this] { return !buffer_.empty() || stop_; });
+        if (buffer_.empty())
+            return;
+        // let more statements join this group
+        if (flush_interval_.count() != 0 && !stop_)
+            pending_cv_.wait_for(lock, flush_interval_, [this] { return stop_; });
+
+        std::string group;
+        group.swap(buffer_);
+        const uint64_t target = appended_;
+        lock.unlock();
+        bool ok = true;
+        try {
+            write_all(fd_, group.data(), group.size());
+            ok = ::fdatasync(fd_) == 0;
+        } catch (const std::runtime_error&) {
+            ok = false;
+        }
+        lock.lock();
+        if (ok)
+            durable_ = target;
+        else
+            failed_ = true;
+        durable_cv_.notify_all();
+    }
+}
+
+void WriteAheadLog::reset(uint32_t checkpoint) {
+    uint64_t lsn;
+    {
+        std::lock_guard lock(mutex_);
+        lsn = appended_;
+    }
+    wait(lsn);
+    std::lock_guard lock(mutex_);
+    create(checkpoint);
+}
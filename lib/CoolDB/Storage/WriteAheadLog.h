@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Append-only log of the statements applied since the last checkpoint:
+//   header:  magic "COOLWAL\0", u32 checkpoint, u32 reserved
+//   record:  u32 length, u32 FNV-1a hash of the bytes, bytes
+// Records are written and fsync'ed by a background thread in groups: a commit waits for the next
+// flush, which happens flush_interval after the first pending record, so statements that arrive
+// in the meantime share one fsync
+class WriteAheadLog final {
+private:
+    std::string path_;
+    int fd_ = -1;
+    uint32_t checkpoint_;
+    std::chrono::milliseconds flush_interval_;
+    std::vector<std::string> recovered_;
+
+    std::mutex mutex_;
+    std::condition_variable pending_cv_;
+    std::condition_variable durable_cv_;
+    std::string buffer_;
+    uint64_t appended_ = 0;
+    uint64_t durable_ = 0;
+    size_t size_ = 0;
+    bool failed_ = false;
+    bool stop_ = false;
+    std::thread flusher_;
+
+    void flush_loop();
+    void create(uint32_t checkpoint);
+public:
+    // Reads the records of the log at path if it continues the given checkpoint,
+    // a missing, stale or torn log is started over from the last whole record
+    WriteAheadLog(const std::string& path, uint32_t checkpoint, std::chrono::milliseconds flush_interval);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // records found on open, in the order they were appended
+    std::vector<std::string> take_recovered();
+
+    // returns once the record is on disk, throws std::runtime_error if the log can't be written
+    void commit(std::string_view record);
+    uint64_t append(std::string_view record);
+    void wait(uint64_t lsn);
+
+    // bytes in the log including the pending records
+    size_t size();
+    uint32_t checkpoint() const;
+    // empties the log after a snapshot of the given checkpoint is on disk
+    void reset(uint32_t checkpoint);
+};
+
+// fsync of a written file, then an atomic rename over to that is itself made durable
+void sync_file(const std::string& path);
+void replace_file(const std::string& from, const std::string& to);
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// B+-tree of (key, row) entries ordered by key, then by row, so equal keys are allowed.
+// Nodes hold fixed arrays of kFanout entries. Copies of a tree share its nodes, a change copies the nodes
+// on its path first, so a tree somebody reads never changes while a copy of it is changed.
+// Erase doesn't merge underfull nodes: separators stay valid bounds, scans skip empty leaves
+template<class T>
+class BPlusTree final {
+public:
+    using key_type = T;
+
+    struct Entry {
+        T key_;
+        size_t row_;
+
+        bool operator<(const Entry& other) const {
+            return key_ < other.key_ || (!(other.key_ < key_) && row_ < other.row_);
+        }
+    };
+private:
+    static constexpr size_t kFanout = 64;
+
+    struct Node {
+        bool leaf_;
+        size_t count_ = 0;
+        // leaves: the entries; inner nodes: entries_[i] is the smallest bound of children_[i + 1]
+        Entry entries_[kFanout];
+        // kFanout + 1 of them in inner nodes, none in leaves
+        std::vector<std::shared_ptr<Node>> children_;
+
+        explicit Node(bool leaf) : leaf_(leaf), children_(leaf ? 0 : kFanout + 1) {}
+    };
+
+    std::shared_ptr<Node> root_;
+    size_t size_ = 0;
+
+    // the node to change, copied first if another tree shares it
+    static Node* own(std::shared_ptr<Node>& node) {
+        // a node held by this tree only can't be taken by anybody else, the trees that let go of it are done
+        if (node.use_count() > 1)
+            node = std::make_shared<Node>(*node);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return node.get();
+    }
+
+    static size_t child_index(const Node* node, const Entry& entry) {
+        return std::upper_bound(node->entries_, node->entries_ + node->count_, entry) - node->entries_;
+    }
+
+    // inserts into the subtree, returns the new right sibling if node was split
+    std::shared_ptr<Node> insert(std::shared_ptr<Node>& owner, const Entry& entry, Entry& separator) {
+        Node* node = own(owner);
+        if (node->leaf_) {
+            Entry* pos = std::lower_bound(node->entries_, node->entries_ + node->count_, entry);
+            std::move_backward(pos, node->entries_ + node->count_, node->entries_ + node->count_ + 1);
+            *pos = entry;
+            if (++node->count_ < kFanout)
+                return nullptr;
+
+            auto right = std::make_shared<Node>(true);
+            const size_t half = kFanout / 2;
+            std::move(node->entries_ + half, node->entries_ + kFanout, right->entries_);
+            right->count_ = kFanout - half;
+            node->count_ = half;
+            separator = right->entries_[0];
+            return right;
+        }
+
+        const size_t index = child_index(node, entry);
+        Entry child_separator;
+        std::shared_ptr<Node> child = insert(node->children_[index], entry, child_separator);
+        if (child == nullptr)
+            return nullptr;
+        auto& children = node->children_;
+        std::move_backward(node->entries_ + index, node->entries_ + node->count_, node->entries_ + node->count_ + 1);
+        std::move_backward(children.begin() + index + 1, children.begin() + node->count_ + 1,
+                           children.begin() + node->count_ + 2);
+        node->entries_[index] = std::move(child_separator);
+        children[index + 1] = std::move(child);
+        if (++node->count_ < kFanout)
+            return nullptr;
+
+        // the middle separator moves up, its right half goes to the new node
+        auto right = std::make_shared<Node>(false);
+        const size_t half = kFanout / 2;
+        separator = std::move(node->entries_[half]);
+        std::move(node->entries_ + half + 1, node->entries_ + kFanout, right->entries_);
+        std::move(children.begin() + half + 1, children.end(), right->children_.begin());
+        right->count_ = kFanout - half - 1;
+        node->count_ = half;
+        return right;
+    }
+
+    const Node* find_leaf(const Entry& entry) const {
+        const Node* node = root_.get();
+        while (node != nullptr && !node->leaf_)
+            node = node->children_[child_index(node, entry)].get();
+        return node;
+    }
+
+    // visits the entries of the subtree from the first one not below bound (a null bound is open)
+    // while they aren't past high. Returns false once one is past high or more than limit were found
+    template<class F>
+    static bool scan(const Node* node, const Entry* bound, const T* high, bool high_inclusive, size_t limit,
+                     size_t& found, F& visit) {
+        if (node->leaf_) {
+            size_t pos = bound == nullptr ? 0 : std::lower_bound(node->entries_, node->entries_ + node->count_, *bound)
+                                                - node->entries_;
+            for (; pos < node->count_; ++pos) {
+                const T& key = node->entries_[pos].key_;
+                if (high != nullptr && (high_inclusive ? *high < key : !(key < *high)))
+                    return false;
+                if (++found > limit)
+                    return false;
+                visit(node->entries_[pos].row_);
+            }
+            return true;
+        }
+        // the children after the first one are above bound
+        for (size_t index = bound == nullptr ? 0 : child_index(node, *bound); index <= node->count_; ++index, bound = nullptr)
+            if (!scan(node->children_[index].get(), bound, high, high_inclusive, limit, found, visit))
+                return false;
+        return true;
+    }
+
+    // every row moves down by the number of deleted rows (ascending) below it
+    static void remove_rows(std::shared_ptr<Node>& owner, const std::vector<size_t>& deleted) {
+        Node* node = own(owner);
+        for (size_t i = 0; i < node->count_; ++i) {
+            size_t& row = node->entries_[i].row_;
+            row -= std::lower_bound(deleted.begin(), deleted.end(), row) - deleted.begin();
+        }
+        if (!node->leaf_)
+            for (size_t i = 0; i <= node->count_; ++i)
+                remove_rows(node->children_[i], deleted);
+    }
+public:
+    size_t size() const { return size_; }
+
+    void clear() {
+        root_.reset();
+        size_ = 0;
+    }
+
+    void insert(const T& key, size_t row) {
+        if (root_ == nullptr)
+            root_ = std::make_shared<Node>(true);
+        Entry separator;
+        std::shared_ptr<Node> right = insert(root_, Entry{key, row}, separator);
+        if (right != nullptr) {
+            auto root = std::make_shared<Node>(false);
+            root->entries_[0] = std::move(separator);
+            root->children_[0] = std::move(root_);
+            root->children_[1] = std::move(right);
+            root->count_ = 1;
+            root_ = std::move(root);
+        }
+        ++size_;
+    }
+
+    bool erase(const T& key, size_t row) {
+        const Entry entry{key, row};
+        const Node* leaf = find_leaf(entry);
+        if (leaf == nullptr)
+            return false;
+        const Entry* found = std::lower_bound(leaf->entries_, leaf->entries_ + leaf->count_, entry);
+        if (found == leaf->entries_ + leaf->count_ || entry < *found)
+            return false;
+        // the path to the leaf is copied where it's shared
+        Node* node = own(root_);
+        while (!node->leaf_)
+            node = own(node->children_[child_index(node, entry)]);
+        Entry* pos = std::lower_bound(node->entries_, node->entries_ + node->count_, entry);
+        std::move(pos + 1, node->entries_ + node->count_, pos);
+        --node->count_;
+        --size_;
+        return true;
+    }
+
+    // replaces the content with sorted entries, leaves are filled completely
+    void build(std::vector<Entry> entries) {
+        clear();
+        size_ = entries.size();
+        std::vector<std::shared_ptr<Node>> level;
+        std::vector<Entry> bounds;
+        for (size_t i = 0; i < entries.size(); i += kFanout - 1) {
+            auto leaf = std::make_shared<Node>(true);
+            leaf->count_ = std::min(kFanout - 1, entries.size() - i);
+            std::move(entries.begin() + i, entries.begin() + i + leaf->count_, leaf->entries_);
+            bounds.push_back(leaf->entries_[0]);
+            level.push_back(std::move(leaf));
+        }
+        if (level.empty())
+            return;
+
+        while (level.size() > 1) {
+            std::vector<std::shared_ptr<Node>> parents;
+            std::vector<Entry> parent_bounds;
+            for (size_t i = 0; i < level.size(); i += kFanout) {
+                auto node = std::make_shared<Node>(false);
+                const size_t children = std::min(kFanout, level.size() - i);
+                for (size_t j = 0; j < children; ++j) {
+                    node->children_[j] = std::move(level[i + j]);
+                    if (j != 0)
+                        node->entries_[j - 1] = bounds[i + j];
+                }
+                node->count_ = children - 1;
+                parents.push_back(std::move(node));
+                parent_bounds.push_back(bounds[i]);
+            }
+            level.swap(parents);
+            bounds.swap(parent_bounds);
+        }
+        root_ = std::move(level.front());
+    }
+
+    // calls visit(row) for the entries from the first one not below low (above it if !low_inclusive)
+    // while they are below high (not above it if high_inclusive); null bounds are open.
+    // Stops and returns false if more than limit entries match
+    template<class F>
+    bool scan(const T* low, bool low_inclusive, const T* high, bool high_inclusive, size_t limit, F visit) const {
+        if (root_ == nullptr)
+            return true;
+        size_t found = 0;
+        if (low != nullptr) {
+            const Entry bound{*low, low_inclusive ? size_t{0} : static_cast<size_t>(-1)};
+            scan(root_.get(), &bound, high, high_inclusive, limit, found, visit);
+        } else {
+            scan(root_.get(), nullptr, high, high_inclusive, limit, found, visit);
+        }
+        return found <= limit;
+    }
+
+    // every row moves down by the number of deleted rows (ascending) below it, in leaves and separators alike.
+    // The mapping keeps the order of the entries, so the tree stays valid
+    void remove_rows(const std::vector<size_t>& deleted) {
+        if (root_ != nullptr)
+            remove_rows(root_, deleted);
+    }
+};
@@ -0,0 +1,161 @@
+#include "Bitmap.h"
+
+#include <algorithm>
+#include <bit>
+
+Bitmap::Bitmap(size_t n, bool value) : words_((n + kWordBits - 1) / kWordBits, value ? ~uint64_t{0} : 0), size_(n) {
+    clear_tail();
+}
+
+void Bitmap::write_bits(size_t index, uint64_t bits, size_t n) {
+    const uint64_t mask = n == kWordBits ? ~uint64_t{0} : (uint64_t{1} << n) - 1;
+    bits &= mask;
+    const size_t word = index / kWordBits, shift = index % kWordBits;
+    words_[word] = (words_[word] & ~(mask << shift)) | (bits << shift);
+    if (shift != 0 && shift + n > kWordBits)
+        words_[word + 1] = (words_[word + 1] & ~(mask >> (kWordBits - shift))) | (bits >> (kWordBits - shift));
+}
+
+void Bitmap::clear_tail() {
+    if (size_ % kWordBits != 0)
+        words_.back() &= (uint64_t{1} << (size_ % kWordBits)) - 1;
+}
+
+// ...............INFO
+
+size_t Bitmap::size() const { return size_; }
+
+size_t Bitmap::count() const {
+    size_t ret = 0;
+    for (uint64_t word : words_)
+        ret += std::popcount(word);
+    return ret;
+}
+
+bool Bitmap::any() const {
+    for (uint64_t word : words_)
+        if (word != 0)
+            return true;
+    return false;
+}
+
+bool Bitmap::operator[](size_t index) const { return (words_[index / kWordBits] >> (index % kWordBits)) & 1; }
+
+// ...............BITS
+
+void Bitmap::set(size_t index, bool value) {
+    const uint64_t mask = uint64_t{1} << (index % kWordBits);
+    if (value)
+        words_[index / kWordBits] |= mask;
+    else
+        words_[index / kWordBits] &= ~mask;
+}
+
+void Bitmap::push_back(bool value) {
+    if (size_ % kWordBits == 0)
+        words_.push_back(0);
+    ++size_;
+    set(size_ - 1, value);
+}
+
+void Bitmap::append(const Bitmap& other) {
+    const size_t shift = size_ % kWordBits;
+    if (shift == 0)
+        words_.insert(words_.end(), other.words_.begin(), other.words_.end());
+    else {
+        words_.reserve(words_.size() + other.words_.size());
+        for (uint64_t word : other.words_) {
+            words_.back() |= word << shift;
+            words_.push_back(word >> (kWordBits - shift));
+        }
+    }
+    size_ += other.size_;
+    words_.resize((size_ + kWordBits - 1) / kWordBits);
+}
+
+void Bitmap::erase(size_t index) {
+    // shift every bit after index one position down
+    size_t word = index / kWordBits;
+    const uint64_t low = (uint64_t{1} << (index % kWordBits)) - 1;
+    uint64_t carry = word + 1 < words_.size() ? words_[word + 1] & 1 : 0;
+    words_[word] = (words_[word] & low) | ((words_[word] >> 1) & ~low) | (carry << (kWordBits - 1));
+    for (++word; word < words_.size(); ++word) {
+        carry = word + 1 < words_.size() ? words_[word + 1] & 1 : 0;
+        words_[word] = (words_[word] >> 1) | (carry << (kWordBits - 1));
+    }
+    --size_;
+    if (size_ % kWordBits == 0)
+        words_.pop_back();
+}
+
+void Bitmap::erase(const std::vector<size_t>& indexes) {
+    if (indexes.empty())
+        return;
+    // the runs between erased bits move down a word at a time, the writes never pass the reads
+    size_t out = indexes.front();
+    for (size_t k = 0; k < indexes.size(); ++k) {
+        size_t from = indexes[k] + 1;
+        const size_t to = k + 1 < indexes.size() ? indexes[k + 1] : size_;
+        while (from < to) {
+            const size_t n = std::min(kWordBits, to - from);
+            const size_t shift = from % kWordBits;
+            uint64_t bits = words_[from / kWordBits] >> shift;
+            if (shift != 0 && from / kWordBits + 1 < words_.size())
+                bits |= words_[from / kWordBits + 1] << (kWordBits - shift);
+            write_bits(out, bits, n);
+            from += n;
+            out += n;
+        }
+    }
+    size_ = out;
+    words_.resize((size_ + kWordBits - 1) / kWordBits);
+    clear_tail();
+}
+
+void Bitmap::reserve(size_t n) { words_.reserve((n + kWordBits - 1) / kWordBits); }
+
+void Bitmap::clear() {
+    words_.clear();
+    size_ = 0;
+}
+
+// ...............WORDS
+
+uint64_t* Bitmap::data() { return words_.data(); }
+
+const uint64_t* Bitmap::data() const { return words_.data(); }
+
+size_t Bitmap::words() const { return words_.size(); }
+
+// ...............LOGIC
+
+Bitmap& Bitmap::operator&=(const Bitmap& other) {
+    for (size_t i = 0; i < words_.size(); ++i)
+        words_[i] &= other.words_[i];
+    return *this;
+}
+
+Bitmap& Bitmap::operator|=(const Bitmap& other) {
+    for (size_t i = 0; i < words_.size(); ++i)
+        words_[i] |= other.words_[i];
+    return *this;
+}
+
+void Bitmap::flip() {
+    for (uint64_t& word : words_)
+        word = ~word;
+    clear_tail();
+}
+
+std::vector<size_t> Bitmap::to_indexes() const {
+    std::vector<size_t> ret;
+    ret.reserve(count());
+    for (size_t i = 0; i < words_.size(); ++i) {
+        uint64_t word = words_[i];
+        while (word != 0) {
+            ret.push_back(i * kWordBits + std::countr_zero(word));
+            word &= word - 1;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Packed bit vector, bit i lives in word i / 64.
+// Used for null masks and for row selections produced by scans
+class Bitmap final {
+private:
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+
+    void clear_tail();
+    // the n low bits of bits go to [index, index + n)
+    void write_bits(size_t index, uint64_t bits, size_t n);
+public:
+    static constexpr size_t kWordBits = 64;
+
+    Bitmap() = default;
+    explicit Bitmap(size_t n, bool value = false);
+
+    // INFO
+    size_t size() const;
+    size_t count() const;
+    bool any() const;
+    bool operator[](size_t index) const;
+
+    // BITS
+    void set(size_t index, bool value = true);
+    void push_back(bool value);
+    void append(const Bitmap& other);
+    void erase(size_t index);
+    // removes the bits at the ascending indexes in one pass
+    void erase(const std::vector<size_t>& indexes);
+    void reserve(size_t n);
+    void clear();
+
+    // WORDS
+    uint64_t* data();
+    const uint64_t* data() const;
+    size_t words() const;
+
+    // LOGIC
+    Bitmap& operator&=(const Bitmap& other);
+    Bitmap& operator|=(const Bitmap& other);
+    void flip();
+
+    // indexes of the set bits in ascending order
+    std::vector<size_t> to_indexes() const;
+};
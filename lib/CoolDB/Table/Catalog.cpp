@@ -0,0 +1,161 @@
+#include "Catalog.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+// ..................HANDLES
+
+Catalog::ReadHandle::ReadHandle(std::shared_ptr<Version> version) : version_(std::move(version)) {}
+
+Catalog::WriteHandle::WriteHandle(std::shared_ptr<Entry> entry) : entry_(std::move(entry)), writer_(entry_->writer_) {
+    std::shared_ptr<Version> latest;
+    {
+        std::shared_lock version(entry_->version_mutex_);
+        latest = entry_->version_;
+    }
+    // the readers go on with the latest version while the statement changes a copy of it
+    draft_ = std::make_shared<Version>(latest->table_->next_version(), latest->schema_);
+    table_ = draft_->table_.get();
+}
+
+Catalog::WriteHandle::WriteHandle(WriteHandle&& other) noexcept
+        : entry_(std::move(other.entry_)), writer_(std::move(other.writer_)), draft_(std::move(other.draft_)),
+          table_(std::exchange(other.table_, nullptr)) {}
+
+Catalog::WriteHandle& Catalog::WriteHandle::operator=(WriteHandle&& other) noexcept {
+    if (this != &other) {
+        release();
+        entry_ = std::move(other.entry_);
+        writer_ = std::move(other.writer_);
+        draft_ = std::move(other.draft_);
+        table_ = std::exchange(other.table_, nullptr);
+    }
+    return *this;
+}
+
+Catalog::WriteHandle::~WriteHandle() { release(); }
+
+void Catalog::WriteHandle::release() {
+    if (entry_ == nullptr)
+        return;
+    std::shared_ptr<Version> old;
+    if (draft_ != nullptr) {
+        std::unique_lock lock(entry_->version_mutex_);
+        old = std::exchange(entry_->version_, std::move(draft_));
+    }
+    writer_.unlock();
+    entry_.reset();
+    table_ = nullptr;
+    // old is freed here, out of the locks, unless readers still hold it
+}
+
+void Catalog::WriteHandle::discard() {
+    if (draft_ != nullptr) {
+        draft_.reset();
+        // the draft took the keys along, only writers use them and this one still holds the table
+        entry_->version_->table_->rebuild_primary_index();
+    }
+    release();
+}
+
+void Catalog::release(std::vector<WriteHandle>& handles) {
+    std::vector<WriteHandle*> drafts;
+    for (WriteHandle& handle : handles)
+        if (handle.draft_ != nullptr)
+            drafts.push_back(&handle);
+    // version locks in address order, like readers take them
+    std::sort(drafts.begin(), drafts.end(), [](const WriteHandle* a, const WriteHandle* b) {
+        return std::less<>()(a->entry_.get(), b->entry_.get());
+    });
+    std::vector<std::shared_ptr<Version>> old;
+    {
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        for (WriteHandle* handle : drafts)
+            locks.emplace_back(handle->entry_->version_mutex_);
+        for (WriteHandle* handle : drafts)
+            old.push_back(std::exchange(handle->entry_->version_, std::move(handle->draft_)));
+    }
+    for (WriteHandle& handle : handles)
+        handle.release();
+}
+
+// ..................TABLES
+
+std::shared_ptr<Catalog::Entry> Catalog::find(std::string_view name) const {
+    std::shared_lock lock(mutex_);
+    auto it = tables_.find(name);
+    return it == tables_.end() ? nullptr : it->second;
+}
+
+std::vector<Catalog::ReadHandle> Catalog::take(const std::vector<std::shared_ptr<Entry>>& entries) {
+    // every version lock is held at once, in address order
+    std::vector<Entry*> order;
+    for (const std::shared_ptr<Entry>& entry : entries)
+        if (entry != nullptr)
+            order.push_back(entry.get());
+    std::sort(order.begin(), order.end(), std::less<>());
+    order.erase(std::unique(order.begin(), order.end()), order.end());
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(order.size());
+    for (Entry* entry : order)
+        locks.emplace_back(entry->version_mutex_);
+
+    std::vector<ReadHandle> ret;
+    ret.reserve(entries.size());
+    for (const std::shared_ptr<Entry>& entry : entries)
+        ret.push_back(entry == nullptr ? ReadHandle() : ReadHandle(entry->version_));
+    return ret;
+}
+
+Catalog::ReadHandle Catalog::read(std::string_view name) const {
+    std::shared_ptr<Entry> entry = find(name);
+    if (entry == nullptr)
+        return {};
+    std::shared_lock lock(entry->version_mutex_);
+    return ReadHandle(entry->version_);
+}
+
+std::vector<Catalog::ReadHandle> Catalog::read(const std::vector<std::string_view>& names) const {
+    std::vector<std::shared_ptr<Entry>> entries;
+    entries.reserve(names.size());
+    for (std::string_view name : names)
+        entries.push_back(find(name));
+    return take(entries);
+}
+
+Catalog::WriteHandle Catalog::write(std::string_view name) const {
+    std::shared_ptr<Entry> entry = find(name);
+    return entry == nullptr ? WriteHandle() : WriteHandle(std::move(entry));
+}
+
+std::vector<Catalog::ReadHandle> Catalog::read_all() const {
+    std::vector<std::shared_ptr<Entry>> entries;
+    {
+        std::shared_lock lock(mutex_);
+        entries = order_;
+    }
+    return take(entries);
+}
+
+bool Catalog::insert(std::unique_ptr<Table> table) {
+    auto entry = std::make_shared<Entry>();
+    const std::string name = table->name();
+    entry->version_ = std::make_shared<Version>(std::move(table), 0);
+    std::unique_lock lock(mutex_);
+    if (!tables_.emplace(name, entry).second)
+        return false;
+    entry->version_->schema_ = next_schema_++;
+    order_.push_back(std::move(entry));
+    return true;
+}
+
+bool Catalog::erase(std::string_view name) {
+    std::unique_lock lock(mutex_);
+    auto it = tables_.find(name);
+    if (it == tables_.end())
+        return false;
+    order_.erase(std::find(order_.begin(), order_.end(), it->second));
+    tables_.erase(it);
+    return true;
+}
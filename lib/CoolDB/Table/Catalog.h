@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Table.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// The tables of a database by name, kept as versions. A reader takes the latest version of a table
+// and reads it without a lock while statements that change the table go on: a version somebody reads
+// is never changed, a statement changes a copy of it that becomes the latest version when it's done.
+// The copy shares the column chunks and index nodes of the version, a change copies only the ones it touches
+// and appended rows go to new chunks. Statements that change one table run one at a time.
+// A version, also one of a dropped table, is freed once the last reader lets go of it
+class Catalog final {
+private:
+    struct Version {
+        std::unique_ptr<Table> table_;
+        // same for every version of a table, a table created again under the name gets a new one
+        uint64_t schema_;
+
+        Version(std::unique_ptr<Table> table, uint64_t schema) : table_(std::move(table)), schema_(schema) {}
+    };
+    struct Entry {
+        std::shared_ptr<Version> version_;
+        // held by the statement that changes the table
+        std::mutex writer_;
+        // held shared while a reader takes version_, alone while a writer replaces it, never while a statement runs
+        std::shared_mutex version_mutex_;
+    };
+public:
+    // a version of a table that stays as it is while it's held, empty if there was no such table
+    class ReadHandle final {
+    private:
+        std::shared_ptr<Version> version_;
+    public:
+        ReadHandle() = default;
+        // takes version, whose entry's version_mutex_ the caller holds
+        explicit ReadHandle(std::shared_ptr<Version> version);
+
+        explicit operator bool() const { return version_ != nullptr; }
+        const Table* get() const { return version_->table_.get(); }
+        const Table* operator->() const { return get(); }
+        // equal for two handles only if their tables have the same columns, see Version::schema_
+        uint64_t schema() const { return version_->schema_; }
+    };
+
+    // a table held by a statement that changes it, empty if there was no such table.
+    // The changes are seen by readers that come after the handle is let go
+    class WriteHandle final {
+        friend class Catalog;
+    private:
+        std::shared_ptr<Entry> entry_;
+        std::unique_lock<std::mutex> writer_;
+        // the copy of the latest version that's changed
+        std::shared_ptr<Version> draft_;
+        Table* table_ = nullptr;
+
+        // makes the draft the latest version and lets go of the table
+        void release();
+    public:
+        WriteHandle() = default;
+        explicit WriteHandle(std::shared_ptr<Entry> entry);
+        WriteHandle(WriteHandle&& other) noexcept;
+        WriteHandle& operator=(WriteHandle&& other) noexcept;
+        ~WriteHandle();
+
+        explicit operator bool() const { return table_ != nullptr; }
+        Table* get() const { return table_; }
+        Table* operator->() const { return get(); }
+
+        // lets go of the table without its changes
+        void discard();
+    };
+private:
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    // guards the map and the order, never held while waiting for a table
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Entry>, Hash, std::equal_to<>> tables_;
+    // the tables in the order they were added, the order of @info and of saved files
+    std::vector<std::shared_ptr<Entry>> order_;
+    uint64_t next_schema_ = 0;
+
+    std::shared_ptr<Entry> find(std::string_view name) const;
+    // the latest versions of entries at one moment, nullptr entries give empty handles
+    static std::vector<ReadHandle> take(const std::vector<std::shared_ptr<Entry>>& entries);
+public:
+    ReadHandle read(std::string_view name) const;
+    // the tables of names as they were at one moment
+    std::vector<ReadHandle> read(const std::vector<std::string_view>& names) const;
+    WriteHandle write(std::string_view name) const;
+    // lets go of every handle, readers see the changes of all of them from one moment on
+    static void release(std::vector<WriteHandle>& handles);
+    // every table as it was at one moment, in the order they were added
+    std::vector<ReadHandle> read_all() const;
+
+    // false if there's already a table with the name of table
+    bool insert(std::unique_ptr<Table> table);
+    // false if there's no such table
+    bool erase(std::string_view name);
+};
@@ -0,0 +1,559 @@
+#include "Column.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+template<class T>
+decltype(auto) from_tablevar(const tablevar& var) {
+    if constexpr (std::is_same_v<T, uint8_t>)
+        return static_cast<uint8_t>(std::get<bool>(var));
+    else
+        return std::get<T>(var);
+}
+
+template<class T>
+tablevar to_tablevar(const T& x) {
+    if constexpr (std::is_same_v<T, uint8_t>)
+        return tablevar{static_cast<bool>(x)};
+    else
+        return tablevar{x};
+}
+
+// calls f with the std::type_identity of the storage type of type
+template<class F>
+static decltype(auto) visit_type(kTypeId type, F&& f) {
+    switch (type) {
+        case kTypeId::INT:
+            return f(std::type_identity<int32_t>());
+        case kTypeId::FLOAT:
+            return f(std::type_identity<float>());
+        case kTypeId::DOUBLE:
+            return f(std::type_identity<double>());
+        case kTypeId::BOOL:
+            return f(std::type_identity<uint8_t>());
+        case kTypeId::STRING:
+            return f(std::type_identity<std::string>());
+        default:
+            return f(std::type_identity<Null>());
+    }
+}
+
+Column::Storage::Storage(kTypeId type, bool encoded, size_t capacity) : codes_(encoded ? capacity : 0) {
+    visit_type(type, [this, encoded, capacity](auto type) {
+        using T = typename decltype(type)::type;
+        data_.emplace<std::vector<T>>(encoded ? 0 : capacity);
+    });
+}
+
+size_t Column::Storage::capacity() const {
+    if (!codes_.empty())
+        return codes_.size();
+    return std::visit([](const auto& values) { return values.size(); }, data_);
+}
+
+std::shared_ptr<Column::Storage> Column::Storage::copy(size_t rows, size_t capacity) const {
+    auto ret = std::make_shared<Storage>(static_cast<kTypeId>(data_.index()), !codes_.empty(), capacity);
+    if (!codes_.empty()) {
+        std::copy_n(codes_.begin(), rows, ret->codes_.begin());
+    } else {
+        std::visit([rows, &ret](const auto& values) {
+            std::copy_n(values.begin(), rows, std::get<std::decay_t<decltype(values)>>(ret->data_).begin());
+        }, data_);
+    }
+    ret->filled_.store(rows, std::memory_order_relaxed);
+    return ret;
+}
+
+void Column::Storage::resize(size_t capacity) {
+    if (!codes_.empty())
+        codes_.resize(capacity);
+    else
+        std::visit([capacity](auto& values) { values.resize(capacity); }, data_);
+}
+
+Column::Column(const kTypeId& type) : type_(type) {}
+
+// ...............INFO
+
+kTypeId Column::type() const { return type_; }
+
+size_t Column::size() const { return size_; }
+
+const uint64_t* Column::null_words(size_t index) const {
+    return chunks_[index / kChunkRows]->nulls_.data() + index % kChunkRows / Bitmap::kWordBits;
+}
+
+bool Column::has_nulls() const { return null_count_ != 0; }
+
+// ...............CHUNKS
+
+Column::Chunk& Column::own_chunk(size_t k) {
+    std::shared_ptr<Chunk>& chunk = chunks_[k];
+    // a chunk held by this column only can't be taken by anybody else, the ones that let go of it are done
+    if (chunk.use_count() > 1)
+        chunk = std::make_shared<Chunk>(*chunk);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return *chunk;
+}
+
+Column::Storage& Column::own_cells(size_t k) {
+    Chunk& chunk = own_chunk(k);
+    if (chunk.cells_.use_count() > 1)
+        chunk.cells_ = chunk.cells_->copy(chunk.nulls_.size(), chunk.cells_->capacity());
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return *chunk.cells_;
+}
+
+void Column::grow(size_t n) {
+    while (n != 0) {
+        const size_t offset = size_ % kChunkRows;
+        const size_t rows = std::min(n, kChunkRows - offset);
+        if (offset == 0) {
+            auto chunk = std::make_shared<Chunk>();
+            // the first chunk grows by doubling, so a small table stays small. A table past it gets whole chunks,
+            // a tail shared with an older version would copy its cells at every doubling
+            const size_t capacity = chunks_.empty() ? rows : kChunkRows;
+            chunk->cells_ = std::make_shared<Storage>(type_, dictionary_ != nullptr, capacity);
+            chunk->cells_->filled_.store(rows, std::memory_order_relaxed);
+            chunk->nulls_ = Bitmap(rows);
+            chunks_.push_back(std::move(chunk));
+        } else {
+            Chunk& chunk = own_chunk(chunks_.size() - 1);
+            Storage* cells = chunk.cells_.get();
+            // the cells after the chunk are free if no other column holds them, or took them first
+            if (chunk.cells_.use_count() == 1) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                cells->filled_.store(offset, std::memory_order_relaxed);
+                // nobody reads them either, so they grow in place and long strings are moved, not copied
+                if (cells->capacity() < offset + rows)
+                    cells->resize(std::min(kChunkRows, std::max(offset + rows, 2 * cells->capacity())));
+            }
+            size_t filled = offset;
+            if (cells->capacity() >= offset + rows && cells->filled_.compare_exchange_strong(filled, offset + rows)) {
+                // a column that let go of them may have left its cells there
+                if (dictionary_ != nullptr)
+                    std::fill_n(cells->codes_.begin() + offset, rows, 0);
+                else
+                    std::visit([offset, rows](auto& values) {
+                        using T = typename std::decay_t<decltype(values)>::value_type;
+                        std::fill_n(values.begin() + offset, rows, T());
+                    }, cells->data_);
+            } else {
+                chunk.cells_ = cells->copy(offset, std::min(kChunkRows, std::max(offset + rows, 2 * cells->capacity())));
+                chunk.cells_->filled_.store(offset + rows, std::memory_order_relaxed);
+            }
+            if (rows == 1)
+                chunk.nulls_.push_back(false);
+            else
+                chunk.nulls_.append(Bitmap(rows));
+        }
+        size_ += rows;
+        n -= rows;
+    }
+}
+
+// ...............DICTIONARY
+
+bool Column::encoded() const { return dictionary_ != nullptr; }
+
+const Dictionary& Column::dictionary() const { return *dictionary_; }
+
+Column::Reader<uint32_t> Column::codes() const {
+    std::vector<const uint32_t*> chunks;
+    chunks.reserve(chunks_.size());
+    for (const auto& chunk : chunks_)
+        chunks.push_back(chunk->cells_->codes_.data());
+    return Reader<uint32_t>(std::move(chunks), size_);
+}
+
+Dictionary& Column::own_dictionary() {
+    if (dictionary_.use_count() > 1)
+        dictionary_ = std::make_shared<Dictionary>(*dictionary_);
+    return *dictionary_;
+}
+
+bool Column::encode(size_t max_size) {
+    if (type_ != kTypeId::STRING || dictionary_ != nullptr)
+        return dictionary_ != nullptr;
+    auto dictionary = std::make_shared<Dictionary>();
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    chunks.reserve(chunks_.size());
+    for (size_t k = 0; k < chunks_.size(); ++k) {
+        const Chunk& chunk = *chunks_[k];
+        const size_t rows = chunk.nulls_.size();
+        const std::vector<std::string>& values = chunk.cells_->cells<std::string>();
+        auto encoded = std::make_shared<Chunk>();
+        encoded->cells_ = std::make_shared<Storage>(type_, true, rows);
+        encoded->cells_->filled_.store(rows, std::memory_order_relaxed);
+        encoded->nulls_ = chunk.nulls_;
+        for (size_t i = 0; i < rows; ++i) {
+            if (chunk.nulls_[i])
+                continue;
+            encoded->cells_->codes_[i] = dictionary->insert(values[i]);
+            if (dictionary_overflows(dictionary->size(), k * kChunkRows + i + 1, max_size))
+                return false;
+        }
+        chunks.push_back(std::move(encoded));
+    }
+    dictionary_ = std::move(dictionary);
+    chunks_ = std::move(chunks);
+    return true;
+}
+
+size_t Column::max_length() const {
+    if (type_ != kTypeId::STRING)
+        return 0;
+    size_t ret = 0;
+    if (dictionary_ != nullptr) {
+        // a code that no cell holds anymore mustn't count
+        std::vector<size_t> lengths(dictionary_->size());
+        for (uint32_t code = 0; code < lengths.size(); ++code)
+            lengths[code] = (*dictionary_)[code].size();
+        const Reader<uint32_t> codes = this->codes();
+        for (size_t i = 0; i < size_; ++i)
+            if (!is_null(i))
+                ret = std::max(ret, lengths[codes[i]]);
+        return ret;
+    }
+    const Reader<std::string> values = this->values<std::string>();
+    for (size_t i = 0; i < size_; ++i)
+        ret = std::max(ret, values[i].size());
+    return ret;
+}
+
+// ...............CELLS
+
+tablevar Column::get(size_t index) const {
+    if (is_null(index))
+        return tablevar{Null()};
+    if (dictionary_ != nullptr)
+        return tablevar{(*dictionary_)[code(index)]};
+    return std::visit([index](const auto& values) { return to_tablevar(values[index % kChunkRows]); },
+                      chunks_[index / kChunkRows]->cells_->data_);
+}
+
+void Column::set(size_t index, const tablevar& value) {
+    const size_t k = index / kChunkRows;
+    const size_t i = index % kChunkRows;
+    if (value.index() == static_cast<size_t>(kTypeId::NULLOBJ)) {
+        Chunk& chunk = own_chunk(k);
+        null_count_ += !chunk.nulls_[i];
+        chunk.nulls_.set(i, true);
+        return;
+    }
+    if (dictionary_ != nullptr) {
+        const uint32_t code = own_dictionary().insert(std::get<std::string>(value));
+        own_cells(k).codes_[i] = code;
+    } else {
+        std::visit([i, &value](auto& values) {
+            using T = typename std::decay_t<decltype(values)>::value_type;
+            values[i] = from_tablevar<T>(value);
+        }, own_cells(k).data_);
+    }
+    Bitmap& nulls = chunks_[k]->nulls_;
+    null_count_ -= nulls[i];
+    nulls.set(i, false);
+}
+
+void Column::set(const std::vector<size_t>& indexes, const tablevar& value) {
+    if (value.index() == static_cast<size_t>(kTypeId::NULLOBJ)) {
+        for (size_t index : indexes)
+            set(index, value);
+        return;
+    }
+    if (dictionary_ != nullptr) {
+        const uint32_t code = own_dictionary().insert(std::get<std::string>(value));
+        for (size_t index : indexes)
+            own_cells(index / kChunkRows).codes_[index % kChunkRows] = code;
+    } else {
+        visit_type(type_, [this, &indexes, &value](auto type) {
+            using T = typename decltype(type)::type;
+            const T x = from_tablevar<T>(value);
+            for (size_t index : indexes)
+                own_cells(index / kChunkRows).cells<T>()[index % kChunkRows] = x;
+        });
+    }
+    for (size_t index : indexes) {
+        Bitmap& nulls = chunks_[index / kChunkRows]->nulls_;
+        null_count_ -= nulls[index % kChunkRows];
+        nulls.set(index % kChunkRows, false);
+    }
+}
+
+void Column::push_back(const tablevar& value) {
+    if (value.index() == static_cast<size_t>(kTypeId::NULLOBJ)) {
+        push_null();
+        return;
+    }
+    // the value is converted first, a wrong one throws before the column changes
+    if (dictionary_ != nullptr) {
+        const uint32_t code = own_dictionary().insert(std::get<std::string>(value));
+        grow(1);
+        chunks_.back()->cells_->codes_[(size_ - 1) % kChunkRows] = code;
+        return;
+    }
+    visit_type(type_, [this, &value](auto type) {
+        using T = typename decltype(type)::type;
+        T x = from_tablevar<T>(value);
+        grow(1);
+        chunks_.back()->cells_->cells<T>()[(size_ - 1) % kChunkRows] = std::move(x);
+    });
+}
+
+void Column::push_back(tablevar&& value) {
+    if (dictionary_ != nullptr || type_ != kTypeId::STRING || value.index() != static_cast<size_t>(kTypeId::STRING)) {
+        push_back(static_cast<const tablevar&>(value));
+        return;
+    }
+    grow(1);
+    chunks_.back()->cells_->cells<std::string>()[(size_ - 1) % kChunkRows] = std::get<std::string>(std::move(value));
+}
+
+void Column::push_null() {
+    grow(1);
+    chunks_.back()->nulls_.set((size_ - 1) % kChunkRows);
+    ++null_count_;
+}
+
+template<class T>
+void Column::assign_chunks(std::vector<T>&& values, const Bitmap& nulls) {
+    const size_t n = nulls.size();
+    chunks_.reserve((n + kChunkRows - 1) / kChunkRows);
+    for (size_t begin = 0; begin < n; begin += kChunkRows) {
+        const size_t rows = std::min(kChunkRows, n - begin);
+        auto chunk = std::make_shared<Chunk>();
+        chunk->cells_ = std::make_shared<Storage>(type_, dictionary_ != nullptr, 0);
+        std::vector<T>& cells = chunk->cells_->cells<T>();
+        if (n <= kChunkRows)
+            cells = std::move(values);
+        else
+            cells.assign(std::make_move_iterator(values.begin() + begin), std::make_move_iterator(values.begin() + begin + rows));
+        chunk->cells_->filled_.store(rows, std::memory_order_relaxed);
+        // a chunk starts at a word of nulls
+        chunk->nulls_ = Bitmap(rows);
+        std::copy_n(nulls.data() + begin / Bitmap::kWordBits, chunk->nulls_.words(), chunk->nulls_.data());
+        chunks_.push_back(std::move(chunk));
+    }
+    size_ = n;
+    null_count_ = nulls.count();
+}
+
+void Column::assign(columndata data, Bitmap nulls) {
+    if (data.index() != static_cast<size_t>(type_))
+        throw std::runtime_error{"Wrong type of column data"};
+    if (std::visit([](const auto& values) { return values.size(); }, data) != nulls.size())
+        throw std::runtime_error{"Column data and null mask sizes differ"};
+    clear();
+    std::visit([this, &nulls](auto& values) { assign_chunks(std::move(values), nulls); }, data);
+}
+
+void Column::assign(std::shared_ptr<Dictionary> dictionary, std::vector<uint32_t> codes, Bitmap nulls) {
+    if (type_ != kTypeId::STRING)
+        throw std::runtime_error{"Wrong type of column data"};
+    if (codes.size() != nulls.size())
+        throw std::runtime_error{"Column data and null mask sizes differ"};
+    clear();
+    dictionary_ = std::move(dictionary);
+    assign_chunks(std::move(codes), nulls);
+}
+
+void Column::append(Column&& other) {
+    if (other.type_ != type_)
+        throw std::runtime_error{"Wrong type of column data"};
+    if (size() == 0) {
+        *this = std::move(other);
+        return;
+    }
+    if (size_ % kChunkRows == 0 && dictionary_ == other.dictionary_) {
+        chunks_.insert(chunks_.end(), std::make_move_iterator(other.chunks_.begin()),
+                       std::make_move_iterator(other.chunks_.end()));
+        size_ += other.size_;
+        null_count_ += other.null_count_;
+    } else if (dictionary_ == other.dictionary_) {
+        // the cells are copied in runs that lie in one chunk of each column,
+        // the ones other holds alone are moved, so its long strings aren't allocated again
+        const size_t from = size_;
+        grow(other.size_);
+        for (size_t i = 0; i < other.size_;) {
+            const size_t to = from + i;
+            const size_t n = std::min({other.size_ - i, kChunkRows - i % kChunkRows, kChunkRows - to % kChunkRows});
+            Chunk& target = *chunks_[to / kChunkRows];
+            const std::shared_ptr<Chunk>& source_chunk = other.chunks_[i / kChunkRows];
+            const Chunk& source = *source_chunk;
+            const bool movable = source_chunk.use_count() == 1 && source.cells_.use_count() == 1;
+            if (dictionary_ != nullptr) {
+                std::copy_n(source.cells_->codes_.begin() + i % kChunkRows, n,
+                            target.cells_->codes_.begin() + to % kChunkRows);
+            } else {
+                std::visit([&target, i, to, n, movable](auto& values) {
+                    auto begin = values.begin() + i % kChunkRows;
+                    auto out = std::get<std::decay_t<decltype(values)>>(target.cells_->data_).begin() + to % kChunkRows;
+                    if (movable)
+                        std::move(begin, begin + n, out);
+                    else
+                        std::copy_n(begin, n, out);
+                }, source.cells_->data_);
+            }
+            if (other.null_count_ != 0)
+                for (size_t j = 0; j < n; ++j)
+                    if (source.nulls_[i % kChunkRows + j])
+                        target.nulls_.set(to % kChunkRows + j);
+            i += n;
+        }
+        null_count_ += other.null_count_;
+    } else {
+        // the strings of other get the codes of this dictionary, or are decoded
+        std::vector<size_t> indexes(other.size());
+        std::iota(indexes.begin(), indexes.end(), size_t{0});
+        gather(other, indexes);
+    }
+    other.clear();
+}
+
+template<class T, class Source>
+void Column::gather_cells(size_t from, const Column& other, const std::vector<size_t>& indexes,
+                          const Source& source, bool parallel) {
+    // the cells of a chunk are written by one task, which owns the words of its null bitmap
+    const size_t first = from / kChunkRows;
+    const size_t chunks = chunks_.size() - first;
+    std::vector<size_t> null_counts(chunks);
+    auto fill = [&](size_t c) {
+        const size_t base = (first + c) * kChunkRows;
+        const size_t end = std::min(from + indexes.size(), base + kChunkRows);
+        T* values = chunks_[first + c]->cells_->cells<T>().data();
+        Bitmap& nulls = chunks_[first + c]->nulls_;
+        for (size_t i = std::max(from, base); i < end; ++i) {
+            const size_t ind = indexes[i - from];
+            if (ind == kNoMatch || other.is_null(ind)) {
+                nulls.set(i - base);
+                ++null_counts[c];
+            } else {
+                values[i - base] = source(ind);
+            }
+        }
+    };
+    if (parallel && chunks > 1) {
+        ThreadPool::instance().parallel_for(chunks, fill);
+    } else {
+        for (size_t c = 0; c < chunks; ++c)
+            fill(c);
+    }
+    for (size_t count : null_counts)
+        null_count_ += count;
+}
+
+void Column::gather(const Column& other, const std::vector<size_t>& indexes) {
+    // an empty column takes the encoding of other, its codes stay valid
+    if (size() == 0 && dictionary_ != other.dictionary_) {
+        dictionary_ = other.dictionary_;
+        chunks_.clear();
+    }
+    if (indexes.empty())
+        return;
+    const size_t from = size_;
+    grow(indexes.size());
+    if (dictionary_ != nullptr && dictionary_ == other.dictionary_) {
+        gather_cells<uint32_t>(from, other, indexes, [&other](size_t ind) { return other.code(ind); }, true);
+    } else if (dictionary_ != nullptr) {
+        Dictionary& dictionary = own_dictionary();
+        gather_cells<uint32_t>(from, other, indexes,
+                               [&other, &dictionary](size_t ind) { return dictionary.insert(other.value<std::string>(ind)); },
+                               false);
+    } else if (other.dictionary_ != nullptr) {
+        gather_cells<std::string>(from, other, indexes, [&other](size_t ind) { return other.value<std::string>(ind); },
+                                  true);
+    } else {
+        visit_type(type_, [this, from, &other, &indexes](auto type) {
+            using T = typename decltype(type)::type;
+            const Reader<T> source = other.values<T>();
+            gather_cells<T>(from, other, indexes, [&source](size_t ind) { return source[ind]; }, true);
+        });
+    }
+}
+
+void Column::erase(size_t index) { erase(std::vector<size_t>{index}); }
+
+void Column::erase(const std::vector<size_t>& indexes) {
+    if (indexes.empty())
+        return;
+    // the cells kept from the chunk of the first erased one on go to new chunks that share the dictionary
+    const size_t first = indexes.front() / kChunkRows;
+    std::vector<size_t> kept;
+    kept.reserve(size_ - first * kChunkRows);
+    for (size_t i = first * kChunkRows, next = 0; i < size_; ++i) {
+        if (next < indexes.size() && indexes[next] == i)
+            ++next;
+        else
+            kept.push_back(i);
+    }
+    Column rest(type_);
+    rest.dictionary_ = dictionary_;
+    rest.gather(*this, kept);
+
+    for (size_t k = first; k < chunks_.size(); ++k)
+        null_count_ -= chunks_[k]->nulls_.count();
+    chunks_.resize(first);
+    size_ = first * kChunkRows;
+    chunks_.insert(chunks_.end(), std::make_move_iterator(rest.chunks_.begin()),
+                   std::make_move_iterator(rest.chunks_.end()));
+    size_ += rest.size_;
+    null_count_ += rest.null_count_;
+}
+
+void Column::reserve(size_t n) { chunks_.reserve((n + kChunkRows - 1) / kChunkRows); }
+
+void Column::clear() {
+    chunks_.clear();
+    size_ = 0;
+    null_count_ = 0;
+    dictionary_.reset();
+}
+
+// ...............COMPARE
+
+bool Column::check_condition(size_t index, const uint8_t& operation, const tablevar& var) const {
+    // NULL cells and constants of another type keep the tablevar semantics
+    if (is_null(index) || var.index() != static_cast<size_t>(type_))
+        return check_operation(get(index), operation, var);
+    if (dictionary_ != nullptr)
+        return check_operation(value<std::string>(index), operation, std::get<std::string>(var));
+
+    return std::visit([index, &operation, &var](const auto& values) {
+        using T = typename std::decay_t<decltype(values)>::value_type;
+        return check_operation(values[index % kChunkRows], operation, from_tablevar<T>(var));
+    }, chunks_[index / kChunkRows]->cells_->data_);
+}
+
+bool Column::less(size_t index, const Column& other, size_t other_index) const {
+    if (is_null(index))
+        return false;
+    if (other.is_null(other_index))
+        return true;
+    if (type_ != other.type_)
+        return type_ < other.type_;
+    if (dictionary_ != nullptr || other.dictionary_ != nullptr)
+        return value<std::string>(index) < other.value<std::string>(other_index);
+    return std::visit([&other, index, other_index](const auto& values) {
+        using V = std::decay_t<decltype(values)>;
+        return values[index % kChunkRows] < std::get<V>(other.chunks_[other_index / kChunkRows]->cells_->data_)[other_index % kChunkRows];
+    }, chunks_[index / kChunkRows]->cells_->data_);
+}
+
+bool Column::equal(size_t index, const Column& other, size_t other_index) const {
+    if (is_null(index) || other.is_null(other_index))
+        return is_null(index) && other.is_null(other_index);
+    if (type_ != other.type_)
+        return false;
+    if (dictionary_ != nullptr && dictionary_ == other.dictionary_)
+        return code(index) == other.code(other_index);
+    if (dictionary_ != nullptr || other.dictionary_ != nullptr)
+        return value<std::string>(index) == other.value<std::string>(other_index);
+    return std::visit([&other, index, other_index](const auto& values) {
+        using V = std::decay_t<decltype(values)>;
+        return values[index % kChunkRows] == std::get<V>(other.chunks_[other_index / kChunkRows]->cells_->data_)[other_index % kChunkRows];
+    }, chunks_[index / kChunkRows]->cells_->data_);
+}
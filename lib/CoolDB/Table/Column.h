@@ -0,0 +1,183 @@
+#pragma once
+
+#include "Row.h"
+#include "Bitmap.h"
+#include "Dictionary.h"
+
+#include <atomic>
+#include <memory>
+
+// row index that stands for a missing row, e.g. the NULL padded side of an outer join
+const size_t kNoMatch = static_cast<size_t>(-1);
+
+// a varchar column of a bulk load is dictionary encoded if at most 1 / kDictionaryFraction of its cells are distinct
+const size_t kDictionaryFraction = 8;
+// encoding gives up at once if more than half of the first kDictionarySample cells are distinct
+const size_t kDictionarySample = 1024;
+
+// whether a dictionary of size strings after the first cells of a column is past max_size or looks hopeless
+inline bool dictionary_overflows(size_t size, size_t cells, size_t max_size) {
+    return size > max_size || (cells == kDictionarySample && size > kDictionarySample / 2);
+}
+
+// bool cells are kept as bytes, so every column type has contiguous storage
+using columndata = std::variant<std::vector<int32_t>, std::vector<float>, std::vector<double>,
+                                std::vector<uint8_t>, std::vector<std::string>, std::vector<Null>>;
+
+// rows of a column chunk, a multiple of the rows of a scan block so a block never spans two chunks
+const size_t kChunkRows = size_t{1} << 12;
+
+// One column of a Table: typed cells plus a null bitmap, kept in chunks of kChunkRows rows.
+// Null cells keep a default value in the typed cells.
+// A STRING column may keep codes into a Dictionary of its distinct strings instead, see encode().
+// Copies of a column share its chunks, a change copies only the chunks it touches first,
+// so a column somebody reads never changes while a copy of it is changed
+class Column final {
+public:
+    // the cells of a column as they were when it was made, they stay valid until the column changes
+    template<class T>
+    class Reader final {
+    private:
+        std::vector<const T*> chunks_;
+        size_t size_ = 0;
+    public:
+        using value_type = T;
+
+        Reader() = default;
+        Reader(std::vector<const T*> chunks, size_t size) : chunks_(std::move(chunks)), size_(size) {}
+
+        size_t size() const { return size_; }
+        const T& operator[](size_t index) const { return chunks_[index / kChunkRows][index % kChunkRows]; }
+        // the cells from index to the end of its chunk are contiguous
+        const T* data(size_t index) const { return chunks_[index / kChunkRows] + index % kChunkRows; }
+    };
+private:
+    // the cells of a chunk and room for more. Cells [0, filled_) belong to the columns sharing it, a column
+    // whose last chunk ends at filled_ may take the cells after it without a copy, readers never see them
+    struct Storage {
+        columndata data_;
+        std::vector<uint32_t> codes_;
+        std::atomic<size_t> filled_ = 0;
+
+        Storage(kTypeId type, bool encoded, size_t capacity);
+        size_t capacity() const;
+        // a copy of the first rows cells with room for capacity ones
+        std::shared_ptr<Storage> copy(size_t rows, size_t capacity) const;
+        // room for capacity cells in place, the cells are moved. Only for storage no other column holds
+        void resize(size_t capacity);
+        // the typed cells, T is uint32_t for codes
+        template<class T>
+        std::vector<T>& cells() {
+            if constexpr (std::is_same_v<T, uint32_t>)
+                return codes_;
+            else
+                return std::get<std::vector<T>>(data_);
+        }
+    };
+    struct Chunk {
+        std::shared_ptr<Storage> cells_;
+        // one bit per row of the chunk
+        Bitmap nulls_;
+    };
+
+    kTypeId type_;
+    // every chunk but the last one holds kChunkRows rows
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    size_t size_ = 0;
+    size_t null_count_ = 0;
+    // set if the strings are dictionary encoded, the chunks hold codes then and a null cell has code 0.
+    // Columns gathered from this one share the dictionary until one of them adds a string
+    std::shared_ptr<Dictionary> dictionary_;
+
+    // the dictionary to add strings to, copied first if it's shared
+    Dictionary& own_dictionary();
+    // chunk k and its cells, copied first if they're shared
+    Chunk& own_chunk(size_t k);
+    Storage& own_cells(size_t k);
+    // adds n cells that are neither null nor set yet at the end, the chunks that get them are owned
+    void grow(size_t n);
+    // the cells of other at indexes from source(index) into [from, from + indexes.size()), made by grow().
+    // kNoMatch gives a NULL cell
+    template<class T, class Source>
+    void gather_cells(size_t from, const Column& other, const std::vector<size_t>& indexes,
+                      const Source& source, bool parallel);
+    // replaces every cell by values split into chunks, a vector of a single chunk is moved in
+    template<class T>
+    void assign_chunks(std::vector<T>&& values, const Bitmap& nulls);
+public:
+    explicit Column(const kTypeId& type);
+
+    // INFO
+    kTypeId type() const;
+    size_t size() const;
+    // a column without NULLs answers without reaching into its chunks
+    bool is_null(size_t index) const {
+        return null_count_ != 0 && chunks_[index / kChunkRows]->nulls_[index % kChunkRows];
+    }
+    // the words of the null bitmap from the one of index to the end of its chunk, chunks start at a word
+    const uint64_t* null_words(size_t index) const;
+    bool has_nulls() const;
+
+    // typed cells, T is the storage type of the column (uint8_t for bool).
+    // A dictionary encoded column has no std::string cells here, see codes()
+    template<class T>
+    Reader<T> values() const {
+        std::vector<const T*> chunks;
+        chunks.reserve(chunks_.size());
+        for (const auto& chunk : chunks_)
+            chunks.push_back(std::get<std::vector<T>>(chunk->cells_->data_).data());
+        return Reader<T>(std::move(chunks), size_);
+    }
+    // typed cell of any column, strings of an encoded column come from its dictionary
+    template<class T>
+    const T& value(size_t index) const {
+        if constexpr (std::is_same_v<T, std::string>)
+            if (dictionary_ != nullptr)
+                return (*dictionary_)[code(index)];
+        return std::get<std::vector<T>>(chunks_[index / kChunkRows]->cells_->data_)[index % kChunkRows];
+    }
+
+    // DICTIONARY
+    bool encoded() const;
+    const Dictionary& dictionary() const;
+    Reader<uint32_t> codes() const;
+    uint32_t code(size_t index) const { return chunks_[index / kChunkRows]->cells_->codes_[index % kChunkRows]; }
+    // keeps the strings of a STRING column as codes if there are at most max_size distinct ones,
+    // returns whether the column is encoded. Strings added later get new codes
+    bool encode(size_t max_size);
+    // length of the longest string of a STRING column, 0 for other types
+    size_t max_length() const;
+
+    // CELLS
+    tablevar get(size_t index) const;
+    void set(size_t index, const tablevar& value);
+    // the same value into every cell at indexes
+    void set(const std::vector<size_t>& indexes, const tablevar& value);
+    void push_back(const tablevar& value);
+    // a string value is moved in
+    void push_back(tablevar&& value);
+    void push_null();
+    // replaces every cell, data must hold the storage type of the column and match nulls in size
+    void assign(columndata data, Bitmap nulls);
+    // replaces every cell of a STRING column by codes into dictionary, which must have every code
+    void assign(std::shared_ptr<Dictionary> dictionary, std::vector<uint32_t> codes, Bitmap nulls);
+    // moves the cells of other of the same type to the end.
+    // The chunks of other are taken over if this column ends at a chunk and both have the same encoding
+    void append(Column&& other);
+
+    // copies the cells of other at the given indexes, kNoMatch gives a NULL cell
+    void gather(const Column& other, const std::vector<size_t>& indexes);
+
+    void erase(size_t index);
+    // removes the cells at the ascending indexes, the chunks before the first one are kept as they are
+    // and the cells after it are copied once
+    void erase(const std::vector<size_t>& indexes);
+    void reserve(size_t n);
+    void clear();
+
+    // COMPARE
+    bool check_condition(size_t index, const uint8_t& operation, const tablevar& var) const;
+    // same results as comparing the cells as tablevar: NULL cells equal each other and go after every value
+    bool less(size_t index, const Column& other, size_t other_index) const;
+    bool equal(size_t index, const Column& other, size_t other_index) const;
+};
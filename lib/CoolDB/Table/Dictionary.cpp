@@ -0,0 +1,38 @@
+#include "Dictionary.h"
+
+#include <algorithm>
+#include <numeric>
+
+size_t Dictionary::size() const { return values_.size(); }
+
+uint32_t Dictionary::find(std::string_view value) const {
+    auto it = codes_.find(value);
+    return it == codes_.end() ? kNoCode : it->second;
+}
+
+uint32_t Dictionary::insert(std::string_view value) {
+    auto it = codes_.find(value);
+    if (it != codes_.end())
+        return it->second;
+    const auto code = static_cast<uint32_t>(values_.size());
+    values_.emplace_back(value);
+    codes_.emplace(values_.back(), code);
+    return code;
+}
+
+std::vector<uint32_t> Dictionary::translate(const Dictionary& other) const {
+    std::vector<uint32_t> ret(other.size());
+    for (uint32_t code = 0; code < other.size(); ++code)
+        ret[code] = find(other[code]);
+    return ret;
+}
+
+std::vector<uint32_t> Dictionary::ranks() const {
+    std::vector<uint32_t> order(values_.size());
+    std::iota(order.begin(), order.end(), uint32_t{0});
+    std::sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs) { return values_[lhs] < values_[rhs]; });
+    std::vector<uint32_t> ret(values_.size());
+    for (uint32_t rank = 0; rank < order.size(); ++rank)
+        ret[order[rank]] = rank;
+    return ret;
+}
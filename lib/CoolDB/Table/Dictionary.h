@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// code that no string of a Dictionary has
+const uint32_t kNoCode = static_cast<uint32_t>(-1);
+
+// The distinct strings of a dictionary encoded column, the code of a string is its position.
+// Codes never change, new strings get the next ones
+class Dictionary final {
+private:
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    std::vector<std::string> values_;
+    std::unordered_map<std::string, uint32_t, Hash, std::equal_to<>> codes_;
+public:
+    size_t size() const;
+    const std::string& operator[](uint32_t code) const { return values_[code]; }
+
+    // kNoCode if there's no such string
+    uint32_t find(std::string_view value) const;
+    // the code of value, a new one if it isn't there yet
+    uint32_t insert(std::string_view value);
+
+    // translate(other)[c] is the code of string c of other in this dictionary, kNoCode if it has none
+    std::vector<uint32_t> translate(const Dictionary& other) const;
+    // ranks()[c] is the position of string c among the sorted strings
+    std::vector<uint32_t> ranks() const;
+};
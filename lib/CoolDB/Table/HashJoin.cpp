@@ -0,0 +1,203 @@
+#include "HashJoin.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+
+// right rows per partition, so one build table stays in L2
+const size_t kPartitionRows = size_t{1} << 14;
+const size_t kMaxPartitionBits = 12;
+const uint32_t kNoEntry = static_cast<uint32_t>(-1);
+const uint64_t kNullHash = 0x2545f4914f6cdd1d;
+
+namespace {
+
+// row indexes of one side grouped by partition, ascending inside every partition
+struct Partitions {
+    std::vector<size_t> rows_;
+    std::vector<uint64_t> hashes_;
+    // partition p holds [offsets_[p], offsets_[p + 1])
+    std::vector<size_t> offsets_;
+};
+
+} // namespace
+
+// V is a std::vector of keys or the Column::Reader of a column
+template<class V>
+static uint64_t key_hash(const Column& column, const V& values, size_t row) {
+    if (column.is_null(row))
+        return kNullHash;
+    // std::hash of integers is the identity, the multiply spreads them to the high bits that pick partitions
+    return static_cast<uint64_t>(std::hash<typename V::value_type>{}(values[row])) * 0x9e3779b97f4a7c15;
+}
+
+template<class V, class W>
+static bool keys_equal(const Column& left, const V& left_values, size_t i,
+                       const Column& right, const W& right_values, size_t j) {
+    const bool left_null = left.is_null(i);
+    const bool right_null = right.is_null(j);
+    if (left_null || right_null)
+        return left_null && right_null;
+    return left_values[i] == right_values[j];
+}
+
+static size_t partition_of(uint64_t hash, size_t bits) { return bits == 0 ? 0 : hash >> (64 - bits); }
+
+// the high bits are the partition, the low ones don't spread the identity hash of small integers well
+static size_t bucket_of(uint64_t hash, size_t buckets) { return (hash ^ (hash >> 32)) & (buckets - 1); }
+
+template<class V>
+static Partitions partition(const Column& column, const V& values, size_t bits) {
+    const size_t n = values.size();
+    const size_t parts = size_t{1} << bits;
+    const size_t morsels = (n + kMorselRows - 1) / kMorselRows;
+    ThreadPool& pool = ThreadPool::instance();
+
+    // every morsel counts its rows per partition, then scatters them from its own cursors
+    std::vector<uint64_t> hashes(n);
+    std::vector<size_t> cursors(morsels * parts);
+    pool.parallel_for(morsels, [&](size_t morsel) {
+        size_t* histogram = cursors.data() + morsel * parts;
+        for (size_t i = morsel * kMorselRows; i < std::min(n, (morsel + 1) * kMorselRows); ++i) {
+            hashes[i] = key_hash(column, values, i);
+            ++histogram[partition_of(hashes[i], bits)];
+        }
+    });
+
+    Partitions ret;
+    ret.offsets_.resize(parts + 1);
+    size_t total = 0;
+    for (size_t p = 0; p < parts; ++p) {
+        ret.offsets_[p] = total;
+        for (size_t morsel = 0; morsel < morsels; ++morsel) {
+            const size_t count = cursors[morsel * parts + p];
+            cursors[morsel * parts + p] = total;
+            total += count;
+        }
+    }
+    ret.offsets_[parts] = total;
+
+    ret.rows_.resize(n);
+    ret.hashes_.resize(n);
+    pool.parallel_for(morsels, [&](size_t morsel) {
+        size_t* cursor = cursors.data() + morsel * parts;
+        for (size_t i = morsel * kMorselRows; i < std::min(n, (morsel + 1) * kMorselRows); ++i) {
+            const size_t pos = cursor[partition_of(hashes[i], bits)]++;
+            ret.rows_[pos] = i;
+            ret.hashes_[pos] = hashes[i];
+        }
+    });
+    return ret;
+}
+
+template<class V, class W>
+static std::vector<std::pair<size_t, size_t>> join_typed(const Column& left, const V& left_values,
+                                                         const Column& right, const W& right_values,
+                                                         bool outer) {
+    // a big left side gets a partition for every worker even if the right one is small, its probes run in parallel
+    const size_t threads = ThreadPool::instance().threads();
+    size_t bits = 0;
+    while (bits < kMaxPartitionBits && ((right_values.size() >> bits) > kPartitionRows ||
+                                        ((size_t{1} << bits) < threads && (left_values.size() >> bits) > kPartitionRows)))
+        ++bits;
+    const size_t parts = size_t{1} << bits;
+    const Partitions left_parts = partition(left, left_values, bits);
+    const Partitions right_parts = partition(right, right_values, bits);
+    ThreadPool& pool = ThreadPool::instance();
+
+    // counts[i] is the number of pairs of left row i, every row is written by its own partition only
+    std::vector<size_t> counts(left_values.size());
+    std::vector<std::vector<std::pair<size_t, size_t>>> found(parts);
+    pool.parallel_for(parts, [&](size_t p) {
+        const size_t begin = right_parts.offsets_[p];
+        const size_t size = right_parts.offsets_[p + 1] - begin;
+        const size_t buckets = std::bit_ceil(std::max<size_t>(size, 1));
+        std::vector<uint32_t> heads(buckets, kNoEntry);
+        std::vector<uint32_t> next(size);
+        // inserted backwards, so a chain lists its right rows in ascending order
+        for (size_t k = size; k-- > 0;) {
+            const size_t bucket = bucket_of(right_parts.hashes_[begin + k], buckets);
+            next[k] = heads[bucket];
+            heads[bucket] = static_cast<uint32_t>(k);
+        }
+
+        std::vector<std::pair<size_t, size_t>>& out = found[p];
+        for (size_t q = left_parts.offsets_[p]; q < left_parts.offsets_[p + 1]; ++q) {
+            const size_t i = left_parts.rows_[q];
+            const uint64_t hash = left_parts.hashes_[q];
+            size_t matches = 0;
+            for (uint32_t k = heads[bucket_of(hash, buckets)]; k != kNoEntry; k = next[k]) {
+                const size_t j = right_parts.rows_[begin + k];
+                if (right_parts.hashes_[begin + k] == hash && keys_equal(left, left_values, i, right, right_values, j)) {
+                    out.emplace_back(i, j);
+                    ++matches;
+                }
+            }
+            if (outer && matches == 0) {
+                out.emplace_back(i, kNoMatch);
+                matches = 1;
+            }
+            counts[i] = matches;
+        }
+    });
+
+    // the pairs of one left row are contiguous in its partition and go to the slot of the row
+    size_t total = 0;
+    for (size_t& count : counts)
+        total += std::exchange(count, total);
+    std::vector<std::pair<size_t, size_t>> pairs(total);
+    pool.parallel_for(parts, [&](size_t p) {
+        for (const auto& pair : found[p])
+            pairs[counts[pair.first]++] = pair;
+    });
+    return pairs;
+}
+
+template<class T>
+static std::vector<std::pair<size_t, size_t>> join_typed(const Column& left, const Column& right, bool outer) {
+    return join_typed(left, left.values<T>(), right, right.values<T>(), outer);
+}
+
+// the strings of a column, encoded or not
+static std::vector<std::string> decoded(const Column& column) {
+    std::vector<std::string> ret(column.size());
+    for (size_t i = 0; i < column.size(); ++i)
+        if (!column.is_null(i))
+            ret[i] = column.value<std::string>(i);
+    return ret;
+}
+
+// keys of two varchar columns of which one is dictionary encoded
+static std::vector<std::pair<size_t, size_t>> join_strings(const Column& left, const Column& right, bool outer) {
+    if (!left.encoded())
+        return join_typed(left, left.values<std::string>(), right, decoded(right), outer);
+    if (!right.encoded())
+        return join_typed(left, decoded(left), right, right.values<std::string>(), outer);
+    // the left strings get the codes of the right dictionary, equal strings have equal codes then
+    std::vector<uint32_t> codes = right.dictionary().translate(left.dictionary());
+    std::vector<uint32_t> left_codes(left.size());
+    const Column::Reader<uint32_t> left_cells = left.codes();
+    for (size_t i = 0; i < left.size(); ++i)
+        if (!left.is_null(i))
+            left_codes[i] = codes[left_cells[i]];
+    return join_typed(left, left_codes, right, right.codes(), outer);
+}
+
+std::vector<std::pair<size_t, size_t>> partitioned_hash_join(const Column& left, const Column& right, bool outer) {
+    switch (left.type()) {
+        case kTypeId::INT:
+            return join_typed<int32_t>(left, right, outer);
+        case kTypeId::FLOAT:
+            return join_typed<float>(left, right, outer);
+        case kTypeId::DOUBLE:
+            return join_typed<double>(left, right, outer);
+        case kTypeId::BOOL:
+            return join_typed<uint8_t>(left, right, outer);
+        case kTypeId::STRING:
+            if (left.encoded() || right.encoded())
+                return join_strings(left, right, outer);
+            return join_typed<std::string>(left, right, outer);
+        default:
+            return join_typed<Null>(left, right, outer);
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Column.h"
+
+#include <utility>
+
+// Radix partitioned hash join of two columns of the same type, run on the ThreadPool.
+// Both sides are split by the high bits of the key hashes into partitions small enough for the cache,
+// then every partition builds a table on its right rows and probes it with its left rows.
+// Returns the matching (left row, right row) pairs ordered by left row, then by right row;
+// with outer a left row without matches gets one (row, kNoMatch) pair. NULL keys match each other
+std::vector<std::pair<size_t, size_t>> partitioned_hash_join(const Column& left, const Column& right, bool outer);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <functional>
 
 class Null {
 public:
@@ -30,3 +31,8 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const Null& n);
 };
 
+template<>
+struct std::hash<Null> {
+    size_t operator()(const Null&) const noexcept { return 0; }
+};
+
@@ -0,0 +1,124 @@
+#include "OrderedIndex.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+template<class T>
+static bool indexable(const T& x) {
+    if constexpr (std::is_floating_point_v<T>)
+        return x == x;
+    else
+        return true;
+}
+
+OrderedIndex::OrderedIndex(const std::string& name, size_t column_index, const Column& column)
+        : name_(name), column_(column_index) {
+    switch (column.type()) {
+        case kTypeId::INT:
+            tree_.emplace<0>();
+            break;
+        case kTypeId::FLOAT:
+            tree_.emplace<1>();
+            break;
+        case kTypeId::DOUBLE:
+            tree_.emplace<2>();
+            break;
+        case kTypeId::BOOL:
+            tree_.emplace<3>();
+            break;
+        case kTypeId::STRING:
+            tree_.emplace<4>();
+            break;
+        case kTypeId::NULLOBJ:
+            throw std::runtime_error{"Can't index a column of NULL type"};
+    }
+    rebuild(column);
+}
+
+const std::string& OrderedIndex::name() const { return name_; }
+
+size_t OrderedIndex::column() const { return column_; }
+
+// ...............MAINTENANCE
+
+void OrderedIndex::insert(const Column& column, size_t row_index) {
+    if (column.is_null(row_index))
+        return;
+    std::visit([&column, row_index](auto& tree) {
+        using Tree = std::decay_t<decltype(tree)>;
+        using T = typename Tree::key_type;
+        const T& value = column.value<T>(row_index);
+        if (indexable(value))
+            tree.insert(value, row_index);
+    }, tree_);
+}
+
+void OrderedIndex::erase(const Column& column, size_t row_index) {
+    if (column.is_null(row_index))
+        return;
+    std::visit([&column, row_index](auto& tree) {
+        using T = typename std::decay_t<decltype(tree)>::key_type;
+        tree.erase(column.value<T>(row_index), row_index);
+    }, tree_);
+}
+
+void OrderedIndex::erase_rows(const Column& column, const std::vector<size_t>& row_indexes) {
+    for (size_t row_index : row_indexes)
+        erase(column, row_index);
+    std::visit([&row_indexes](auto& tree) { tree.remove_rows(row_indexes); }, tree_);
+}
+
+void OrderedIndex::rebuild(const Column& column) {
+    std::visit([&column](auto& tree) {
+        using Tree = std::decay_t<decltype(tree)>;
+        using T = typename Tree::key_type;
+        std::vector<typename Tree::Entry> entries;
+        entries.reserve(column.size());
+        for (size_t i = 0; i < column.size(); ++i)
+            if (!column.is_null(i) && indexable(column.value<T>(i)))
+                entries.push_back({column.value<T>(i), i});
+        std::sort(entries.begin(), entries.end());
+        tree.build(std::move(entries));
+    }, tree_);
+}
+
+// ...............LOOKUP
+
+bool OrderedIndex::find(const std::vector<std::pair<uint8_t, tablevar>>& conditions, size_t limit,
+                        std::vector<size_t>& rows) const {
+    for (const auto& [operation, var] : conditions)
+        if (operation == 1 || operation > 5 || var.index() != tree_.index())
+            return false;
+    return std::visit([&conditions, limit, &rows](const auto& tree) {
+        using T = typename std::decay_t<decltype(tree)>::key_type;
+        // the conditions narrow one range [low, high], a missing bound is open
+        T low{}, high{};
+        bool has_low = false, has_high = false, low_inclusive = true, high_inclusive = true;
+        for (const auto& [operation, var] : conditions) {
+            T constant;
+            if constexpr (std::is_same_v<T, uint8_t>)
+                constant = std::get<bool>(var);
+            else
+                constant = std::get<T>(var);
+            if (!indexable(constant))
+                return true;
+            const bool inclusive = operation == 0 || operation == 3 || operation == 5;
+            if (operation == 0 || operation == 2 || operation == 3) {
+                if (!has_low || low < constant)
+                    low = constant, low_inclusive = inclusive;
+                else if (!(constant < low))
+                    low_inclusive = low_inclusive && inclusive;
+                has_low = true;
+            }
+            if (operation == 0 || operation == 4 || operation == 5) {
+                if (!has_high || constant < high)
+                    high = constant, high_inclusive = inclusive;
+                else if (!(high < constant))
+                    high_inclusive = high_inclusive && inclusive;
+                has_high = true;
+            }
+        }
+        return tree.scan(has_low ? &low : nullptr, low_inclusive, has_high ? &high : nullptr, high_inclusive, limit,
+                         [&rows](size_t row) { rows.push_back(row); });
+    }, tree_);
+}
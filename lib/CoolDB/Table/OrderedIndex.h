@@ -0,0 +1,31 @@
+#pragma once
+
+#include "BPlusTree.h"
+#include "Column.h"
+
+// Secondary index of one column, made by CREATE INDEX.
+// Holds the (value, row) pairs of the non-NULL cells, NaN floats are left out since they never compare true
+class OrderedIndex final {
+private:
+    std::string name_;
+    size_t column_;
+    std::variant<BPlusTree<int32_t>, BPlusTree<float>, BPlusTree<double>,
+                 BPlusTree<uint8_t>, BPlusTree<std::string>> tree_;
+public:
+    OrderedIndex(const std::string& name, size_t column_index, const Column& column);
+
+    const std::string& name() const;
+    size_t column() const;
+
+    // the cell of column at row_index, nothing happens for NULL cells
+    void insert(const Column& column, size_t row_index);
+    void erase(const Column& column, size_t row_index);
+    // drops the cells of the ascending row_indexes, the rows after them move down
+    void erase_rows(const Column& column, const std::vector<size_t>& row_indexes);
+    void rebuild(const Column& column);
+
+    // rows of the non-NULL cells for which every "cell operation var" of conditions holds, in key order.
+    // False if the index can't answer: an operation is !=, a var has another type or more than limit rows match
+    bool find(const std::vector<std::pair<uint8_t, tablevar>>& conditions, size_t limit,
+              std::vector<size_t>& rows) const;
+};
@@ -0,0 +1,308 @@
+#include "Predicate.h"
+#include "ScanKernels.h"
+#include "Table.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// applies the NULL result and NOT of a condition to the compared bits of rows [begin, end)
+void finish_bits(const Column& column, size_t begin, size_t end, bool null_result, bool negate, uint64_t* out) {
+    const size_t words = (end - begin + Bitmap::kWordBits - 1) / Bitmap::kWordBits;
+    if (column.has_nulls()) {
+        const uint64_t* nulls = column.null_words(begin);
+        for (size_t w = 0; w < words; ++w)
+            out[w] = null_result ? (out[w] | nulls[w]) : (out[w] & ~nulls[w]);
+    }
+    if (negate) {
+        for (size_t w = 0; w < words; ++w)
+            out[w] = ~out[w];
+        if ((end - begin) % Bitmap::kWordBits != 0)
+            out[words - 1] &= (uint64_t{1} << ((end - begin) % Bitmap::kWordBits)) - 1;
+    }
+}
+
+template<class T, class Compare>
+std::function<bool(size_t)> make_row_kernel(const Column& column, const T& constant, bool null_result, bool negate) {
+    const Column::Reader<T> values = column.values<T>();
+    if (!column.has_nulls())
+        return [values, constant, negate](size_t i) { return Compare{}(values[i], constant) != negate; };
+    return [&column, values, constant, null_result, negate](size_t i) {
+        return (column.is_null(i) ? null_result : Compare{}(values[i], constant)) != negate;
+    };
+}
+
+template<class T>
+std::function<bool(size_t)> make_row_kernel(const Column& column, const uint8_t& operation, const T& constant,
+                                            bool null_result, bool negate) {
+    switch (operation) {
+        case 0:
+            return make_row_kernel<T, std::equal_to<T>>(column, constant, null_result, negate);
+        case 1:
+            return make_row_kernel<T, std::not_equal_to<T>>(column, constant, null_result, negate);
+        case 2:
+            return make_row_kernel<T, std::greater<T>>(column, constant, null_result, negate);
+        case 3:
+            return make_row_kernel<T, std::greater_equal<T>>(column, constant, null_result, negate);
+        case 4:
+            return make_row_kernel<T, std::less<T>>(column, constant, null_result, negate);
+        case 5:
+            return make_row_kernel<T, std::less_equal<T>>(column, constant, null_result, negate);
+        default:
+            return [negate](size_t) { return negate; };
+    }
+}
+
+template<class T>
+std::function<void(size_t, size_t, uint64_t*)> make_batch_kernel(const Column& column, const uint8_t& operation,
+                                                                  const T& constant, bool null_result, bool negate) {
+    const Column::Reader<T> values = column.values<T>();
+    return [&column, values, operation, constant, null_result, negate](size_t begin, size_t end, uint64_t* out) {
+        compare_values(values.data(begin), end - begin, operation, constant, out);
+        finish_bits(column, begin, end, null_result, negate, out);
+    };
+}
+
+// a condition on a dictionary encoded column is decided once per string of the dictionary, the scan reads codes
+Predicate::Kernel make_dictionary_kernel(const Column& column, const uint8_t& operation, const std::string& constant,
+                                         bool null_result, bool negate) {
+    const Column::Reader<uint32_t> codes = column.codes();
+    if (operation == 0 || operation == 1) {
+        // codes are below 2^31 and a missing string is kNoCode, -1 as an int, which no code equals
+        const auto code = static_cast<int32_t>(column.dictionary().find(constant));
+        const bool equal = operation == 0;
+        auto row = [&column, codes, code, equal, null_result, negate](size_t i) {
+            return (column.is_null(i) ? null_result : (static_cast<int32_t>(codes[i]) == code) == equal) != negate;
+        };
+        auto batch = [&column, codes, operation, code, null_result, negate](size_t begin, size_t end, uint64_t* out) {
+            compare_values(reinterpret_cast<const int32_t*>(codes.data(begin)), end - begin, operation, code, out);
+            finish_bits(column, begin, end, null_result, negate, out);
+        };
+        Predicate::Kernel kernel;
+        kernel.row_ = std::move(row);
+        kernel.batch_ = std::move(batch);
+        return kernel;
+    }
+
+    // null cells have code 0, an empty dictionary still gets an entry for them
+    auto matches = std::make_shared<std::vector<uint8_t>>(std::max<size_t>(column.dictionary().size(), 1));
+    for (uint32_t code = 0; code < column.dictionary().size(); ++code)
+        (*matches)[code] = check_operation(column.dictionary()[code], operation, constant);
+    auto row = [&column, codes, matches, null_result, negate](size_t i) {
+        return (column.is_null(i) ? null_result : (*matches)[codes[i]] != 0) != negate;
+    };
+    auto batch = [&column, codes, matches, null_result, negate](size_t begin, size_t end, uint64_t* out) {
+        const uint32_t* block = codes.data(begin);
+        for (size_t w = 0; w * Bitmap::kWordBits < end - begin; ++w) {
+            const size_t first = w * Bitmap::kWordBits;
+            const size_t last = std::min(end - begin, first + Bitmap::kWordBits);
+            uint64_t word = 0;
+            for (size_t i = first; i < last; ++i)
+                word |= static_cast<uint64_t>((*matches)[block[i]]) << (i - first);
+            out[w] = word;
+        }
+        finish_bits(column, begin, end, null_result, negate, out);
+    };
+    Predicate::Kernel kernel;
+    kernel.row_ = std::move(row);
+    kernel.batch_ = std::move(batch);
+    return kernel;
+}
+
+Predicate::Predicate(const Table* table, std::vector<std::forward_list<Condition>> check_list)
+        : check_list_(std::move(check_list)) {
+    for (const auto& conditions : check_list_) {
+        groups_.emplace_back();
+        for (const auto& condition : conditions) {
+            const Column& column = table->get_column(condition.column_);
+            Kernel kernel = compile(column, condition);
+            // NULL cells aren't indexed, so the index only helps if they can't match
+            const bool null_result = check_operation(tablevar{Null()}, condition.op_, condition.data_);
+            if (!condition.not_ && condition.op_ != 1 && (!null_result || !column.has_nulls())) {
+                kernel.index_ = table->get_index(condition.column_);
+                kernel.op_ = condition.op_;
+                kernel.constant_ = condition.data_;
+            }
+            groups_.back().push_back(std::move(kernel));
+        }
+    }
+}
+
+template<class T>
+Predicate::Kernel make_kernel(const Column& column, const uint8_t& operation, const T& constant, bool null_result, bool negate) {
+    Predicate::Kernel kernel;
+    kernel.row_ = make_row_kernel<T>(column, operation, constant, null_result, negate);
+    kernel.batch_ = make_batch_kernel<T>(column, operation, constant, null_result, negate);
+    return kernel;
+}
+
+Predicate::Kernel Predicate::compile(const Column& column, const Condition& condition) {
+    const uint8_t& op = condition.op_;
+    const tablevar& var = condition.data_;
+    // NULL cells are compared as tablevar, it's a constant for the whole query
+    const bool null_result = check_operation(tablevar{Null()}, op, var);
+    const bool negate = condition.not_;
+
+    if (var.index() == static_cast<size_t>(column.type())) {
+        switch (column.type()) {
+            case kTypeId::INT:
+                return make_kernel<int32_t>(column, op, std::get<int32_t>(var), null_result, negate);
+            case kTypeId::FLOAT:
+                return make_kernel<float>(column, op, std::get<float>(var), null_result, negate);
+            case kTypeId::DOUBLE:
+                return make_kernel<double>(column, op, std::get<double>(var), null_result, negate);
+            case kTypeId::BOOL:
+                return make_kernel<uint8_t>(column, op, static_cast<uint8_t>(std::get<bool>(var)), null_result, negate);
+            case kTypeId::STRING:
+                if (column.encoded())
+                    return make_dictionary_kernel(column, op, std::get<std::string>(var), null_result, negate);
+                return make_kernel<std::string>(column, op, std::get<std::string>(var), null_result, negate);
+            case kTypeId::NULLOBJ:
+                break;
+        }
+    }
+
+    auto row = [&column, condition](size_t i) { return column.check_condition(i, condition.op_, condition.data_) != condition.not_; };
+    auto batch = [row](size_t begin, size_t end, uint64_t* out) {
+        std::fill(out, out + (end - begin + Bitmap::kWordBits - 1) / Bitmap::kWordBits, 0);
+        for (size_t i = begin; i < end; ++i)
+            out[(i - begin) / Bitmap::kWordBits] |= static_cast<uint64_t>(row(i)) << ((i - begin) % Bitmap::kWordBits);
+    };
+    Kernel kernel;
+    kernel.row_ = std::move(row);
+    kernel.batch_ = std::move(batch);
+    return kernel;
+}
+
+const std::vector<std::forward_list<Condition>>& Predicate::conditions() const { return check_list_; }
+
+bool Predicate::operator()(size_t row_index) const {
+    for (const auto& group : groups_) {
+        bool flag = true;
+        for (const auto& check : group) {
+            if (!check.row_(row_index)) {
+                flag = false;
+                break;
+            }
+        }
+        if (flag)
+            return true;
+    }
+
+    return false;
+}
+
+bool Predicate::evaluate_indexed(const std::vector<Kernel>& group, size_t rows, std::vector<size_t>& result) {
+    auto indexed = std::find_if(group.begin(), group.end(), [](const Kernel& check) { return check.index_ != nullptr; });
+    if (indexed == group.end())
+        return false;
+    // every condition on the indexed column bounds the same range, like "x >= a AND x < b"
+    std::vector<std::pair<uint8_t, tablevar>> range;
+    for (const Kernel& check : group)
+        if (check.index_ == indexed->index_)
+            range.emplace_back(check.op_, check.constant_);
+    std::vector<size_t> found;
+    if (!indexed->index_->find(range, rows / kIndexFraction, found))
+        return false;
+
+    // the rest of the group is checked row by row on the few rows found
+    for (size_t row : found) {
+        bool flag = true;
+        for (auto check = group.begin(); check != group.end() && flag; ++check)
+            flag = check->index_ == indexed->index_ || check->row_(row);
+        if (flag)
+            result.push_back(row);
+    }
+    return true;
+}
+
+Bitmap Predicate::evaluate(size_t rows) const {
+    // a block lies in one chunk of a column, its cells are contiguous
+    static_assert(kMorselRows % kBlockRows == 0 && kChunkRows % kBlockRows == 0);
+    Bitmap result(rows);
+
+    std::vector<const std::vector<Kernel>*> scanned;
+    std::vector<size_t> found;
+    for (const auto& group : groups_)
+        if (!evaluate_indexed(group, rows, found))
+            scanned.push_back(&group);
+    for (size_t row : found)
+        result.set(row);
+    if (scanned.empty())
+        return result;
+
+    // each morsel fills its own words of result
+    ThreadPool::instance().parallel_for((rows + kMorselRows - 1) / kMorselRows, [&](size_t morsel) {
+        evaluate_blocks(scanned, morsel * kMorselRows, std::min(rows, (morsel + 1) * kMorselRows),
+                        result.data() + morsel * kMorselRows / Bitmap::kWordBits);
+    });
+    return result;
+}
+
+void Predicate::evaluate_blocks(const std::vector<const std::vector<Kernel>*>& groups, size_t from, size_t to,
+                                uint64_t* result) {
+    constexpr size_t kBlockWords = kBlockRows / Bitmap::kWordBits;
+    uint64_t group_bits[kBlockWords];
+    uint64_t term_bits[kBlockWords];
+
+    for (size_t begin = from; begin < to; begin += kBlockRows) {
+        const size_t end = std::min(to, begin + kBlockRows);
+        const size_t words = (end - begin + Bitmap::kWordBits - 1) / Bitmap::kWordBits;
+        uint64_t* out = result + (begin - from) / Bitmap::kWordBits;
+        for (const auto* group : groups) {
+            std::fill(group_bits, group_bits + words, ~uint64_t{0});
+            if ((end - begin) % Bitmap::kWordBits != 0)
+                group_bits[words - 1] = (uint64_t{1} << ((end - begin) % Bitmap::kWordBits)) - 1;
+
+            for (const auto& check : *group) {
+                check.batch_(begin, end, term_bits);
+                uint64_t any = 0;
+                for (size_t w = 0; w < words; ++w) {
+                    group_bits[w] &= term_bits[w];
+                    any |= group_bits[w];
+                }
+                if (any == 0)
+                    break;
+            }
+            for (size_t w = 0; w < words; ++w)
+                out[w] |= group_bits[w];
+        }
+    }
+}
+
+std::vector<size_t> Predicate::find_rows(size_t rows) const {
+    std::vector<size_t> found;
+    if (!find_indexed(rows, found))
+        return evaluate(rows).to_indexes();
+    return found;
+}
+
+bool Predicate::find_indexed(size_t rows, std::vector<size_t>& found) const {
+    found.clear();
+    for (const auto& group : groups_) {
+        if (!evaluate_indexed(group, rows, found)) {
+            found.clear();
+            return false;
+        }
+    }
+    std::sort(found.begin(), found.end());
+    // a row may match several groups
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    return true;
+}
+
+std::vector<size_t> Predicate::scan_rows(size_t from, size_t to) const {
+    std::vector<const std::vector<Kernel>*> groups;
+    for (const auto& group : groups_)
+        groups.push_back(&group);
+    Bitmap result(to - from);
+    ThreadPool::instance().parallel_for((to - from + kMorselRows - 1) / kMorselRows, [&](size_t morsel) {
+        const size_t begin = from + morsel * kMorselRows;
+        evaluate_blocks(groups, begin, std::min(to, begin + kMorselRows),
+                        result.data() + morsel * kMorselRows / Bitmap::kWordBits);
+    });
+
+    std::vector<size_t> found = result.to_indexes();
+    for (size_t& row : found)
+        row += from;
+    return found;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Column.h"
+#include "OrderedIndex.h"
+
+#include <functional>
+
+class Table;
+
+// WHERE clause compiled against the columns of one table.
+// Every condition becomes a comparison specialized for the column type and the operation,
+// so the scan loop never compares tablevar objects
+class Predicate final {
+public:
+    struct Kernel {
+        std::function<bool(size_t)> row_;
+        // fills the bits of rows [begin, end) into out, begin is a multiple of 64
+        std::function<void(size_t, size_t, uint64_t*)> batch_;
+        // set if an OrderedIndex of the column can answer the condition
+        const OrderedIndex* index_ = nullptr;
+        uint8_t op_ = 0;
+        tablevar constant_;
+    };
+private:
+    std::vector<std::forward_list<Condition>> check_list_;
+    // OR of AND groups
+    std::vector<std::vector<Kernel>> groups_;
+
+    static Kernel compile(const Column& column, const Condition& condition);
+    // appends the rows of an AND group found through an index, false if the group needs a scan
+    static bool evaluate_indexed(const std::vector<Kernel>& group, size_t rows, std::vector<size_t>& result);
+    // ORs the scanned groups of rows [from, to) into the bits of result, its first bit is row from.
+    // from is a multiple of kBlockRows
+    static void evaluate_blocks(const std::vector<const std::vector<Kernel>*>& groups, size_t from, size_t to,
+                                uint64_t* result);
+public:
+    // rows evaluated at once by evaluate(), the bitmaps of one block stay in L1
+    static constexpr size_t kBlockRows = 2048;
+    // an index is used while it yields at most 1 / kIndexFraction of the rows, a scan is cheaper beyond that
+    static constexpr size_t kIndexFraction = 16;
+
+    Predicate() = default;
+    Predicate(const Table* table, std::vector<std::forward_list<Condition>> check_list);
+
+    const std::vector<std::forward_list<Condition>>& conditions() const;
+
+    bool operator()(size_t row_index) const;
+
+    // selection bitmap of the rows [0, rows): AND groups combine with bitwise ops, then get OR-ed.
+    // The scanned morsels are spread over the ThreadPool
+    Bitmap evaluate(size_t rows) const;
+    // the matching rows in ascending order, no bitmap of all rows is made if indexes answer every group
+    std::vector<size_t> find_rows(size_t rows) const;
+    // the matching rows of [0, rows) in ascending order if indexes answer every group, false otherwise
+    bool find_indexed(size_t rows, std::vector<size_t>& found) const;
+    // the matching rows of [from, to) in ascending order found by a scan, from is a multiple of kBlockRows.
+    // Lets a pipeline evaluate a table piece by piece
+    std::vector<size_t> scan_rows(size_t from, size_t to) const;
+};
@@ -0,0 +1,65 @@
+#include "PrimaryKeyIndex.h"
+
+#include <algorithm>
+
+size_t KeyHash::operator()(const tablekey& key) const {
+    size_t seed = key.size();
+    for (const auto& x : key)
+        seed ^= std::hash<tablevar>{}(x) + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+// ..................COLUMNS
+
+void PrimaryKeyIndex::add_column(size_t column_index) {
+    if (std::find(key_columns_.begin(), key_columns_.end(), column_index) == key_columns_.end())
+        key_columns_.push_back(column_index);
+}
+
+const std::vector<size_t>& PrimaryKeyIndex::columns() const { return key_columns_; }
+
+bool PrimaryKeyIndex::empty() const { return key_columns_.empty(); }
+
+// ..................KEYS
+
+tablekey PrimaryKeyIndex::key_of(const Row& row) const {
+    tablekey key;
+    key.reserve(key_columns_.size());
+    for (size_t ind : key_columns_)
+        key.push_back(row[ind]);
+    return key;
+}
+
+tablekey PrimaryKeyIndex::key_of(const std::vector<Column>& columns, size_t row_index) const {
+    tablekey key;
+    key.reserve(key_columns_.size());
+    for (size_t ind : key_columns_)
+        key.push_back(columns[ind].get(row_index));
+    return key;
+}
+
+bool PrimaryKeyIndex::contains(const tablekey& key) const { return keys_.contains(key); }
+
+bool PrimaryKeyIndex::insert(const Row& row) {
+    if (empty())
+        return true;
+    return insert(key_of(row));
+}
+
+bool PrimaryKeyIndex::insert(tablekey key) { return keys_.insert(std::move(key)).second; }
+
+void PrimaryKeyIndex::erase(const std::vector<Column>& columns, size_t row_index) {
+    if (!empty())
+        keys_.erase(key_of(columns, row_index));
+}
+
+void PrimaryKeyIndex::erase(const tablekey& key) { keys_.erase(key); }
+
+void PrimaryKeyIndex::reserve(size_t n) { keys_.reserve(n); }
+
+void PrimaryKeyIndex::clear() { keys_.clear(); }
+
+void PrimaryKeyIndex::drop() {
+    keys_.clear();
+    key_columns_.clear();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Column.h"
+
+#include <unordered_set>
+
+using tablekey = std::vector<tablevar>;
+
+struct KeyHash {
+    size_t operator()(const tablekey& key) const;
+};
+
+// Hash set of composite primary key tuples, kept alongside the rows of a Table
+class PrimaryKeyIndex final {
+private:
+    std::vector<size_t> key_columns_;
+    std::unordered_set<tablekey, KeyHash> keys_;
+public:
+    PrimaryKeyIndex() = default;
+
+    void add_column(size_t column_index);
+    const std::vector<size_t>& columns() const;
+    bool empty() const;
+
+    tablekey key_of(const Row& row) const;
+    tablekey key_of(const std::vector<Column>& columns, size_t row_index) const;
+    bool contains(const tablekey& key) const;
+
+    // false if the key is already there
+    bool insert(const Row& row);
+    bool insert(tablekey key);
+    void erase(const std::vector<Column>& columns, size_t row_index);
+    void erase(const tablekey& key);
+    void reserve(size_t n);
+    void clear();
+    void drop();
+};
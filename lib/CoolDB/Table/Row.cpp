@@ -1,6 +1,8 @@
 #include "Row.h"
 
+#include <charconv>
 #include <iomanip>
+#include <stdexcept>
 #include <utility>
 
 
@@ -15,56 +17,41 @@ Row::Row(const size_t& n) {
 tablevar& Row::operator[](size_t index) { return items_[index]; }
 const tablevar& Row::operator[](size_t index) const {return items_[index]; }
 
-void Row::print() const {
+void Row::print(std::ostream& out) const {
     for (const auto& x : items_) {
         try {
-            std::cout << std::setw(kPrintWidth) << std::get<int32_t>(x) << kDelimiter;
+            out << std::setw(kPrintWidth) << std::get<int32_t>(x) << kDelimiter;
         } catch (const std::bad_variant_access& e) {
             try {
-                std::cout << std::setw(kPrintWidth) << std::get<double>(x) << kDelimiter;
+                out << std::setw(kPrintWidth) << std::get<double>(x) << kDelimiter;
             } catch (const std::bad_variant_access& e) {
                 try {
-                    std::cout << std::setw(kPrintWidth) << std::get<float>(x) << kDelimiter;
+                    out << std::setw(kPrintWidth) << std::get<float>(x) << kDelimiter;
                 } catch (const std::bad_variant_access& e) {
                     try {
-                        std::cout << std::setw(kPrintWidth) << std::get<bool>(x) << kDelimiter;
+                        out << std::setw(kPrintWidth) << std::get<bool>(x) << kDelimiter;
                     } catch (const std::bad_variant_access& e) {
                         try {
-                            std::cout << std::setw(kPrintWidth) << std::get<std::string>(x) << kDelimiter;
+                            out << std::setw(kPrintWidth) << std::get<std::string>(x) << kDelimiter;
                         } catch (const std::bad_variant_access& e) {
-                            std::cout << std::setw(kPrintWidth) << std::get<Null>(x) << kDelimiter;
+                            out << std::setw(kPrintWidth) << std::get<Null>(x) << kDelimiter;
                         }
                     }
                 }
             }
         }
     }
-    std::cout << std::endl;
+    out << std::endl;
 }
 
 void Row::push_back(const tablevar &n) { items_.push_back(n); }
 
 bool Row::check_condition(size_t column_index, const std::string& operation, const tablevar& var) const {
-    return check_condition(column_index, kOperationsID[operation], var);
+    return check_condition(column_index, kOperationsID.at(operation), var);
 }
 
 bool Row::check_condition(size_t column_index, const uint8_t& operation, const tablevar& var) const {
-    switch (operation) {
-        case 0:
-            return items_[column_index] == var;
-        case 1:
-            return items_[column_index] != var;
-        case 2:
-            return items_[column_index] > var;
-        case 3:
-            return items_[column_index] >= var;
-        case 4:
-            return items_[column_index] < var;
-        case 5:
-            return items_[column_index] <= var;
-        default:
-            return false;
-    }
+    return check_operation(items_[column_index], operation, var);
 }
 
 bool Row::check_condition_list(const std::vector<std::forward_list<Condition>>& check_list) const {
@@ -96,18 +83,30 @@ Row Row::align_to(size_t n) {
     return ret;
 }
 
-tablevar string_to_tablevar(const std::string& s, const kTypeId& type) {
+template<class T>
+static T parse_number(std::string_view s) {
+    // from_chars doesn't skip a leading '+' unlike stoi
+    if (!s.empty() && s.front() == '+')
+        s.remove_prefix(1);
+    T ret{};
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), ret);
+    if (ec != std::errc())
+        throw std::runtime_error{"Wrong value " + std::string(s)};
+    return ret;
+}
+
+tablevar string_to_tablevar(std::string_view s, const kTypeId& type) {
     switch (type) {
         case kTypeId::INT:
-            return tablevar{std::stoi(s)};
+            return tablevar{parse_number<int32_t>(s)};
         case kTypeId::FLOAT:
-            return tablevar{std::stof(s)};
+            return tablevar{parse_number<float>(s)};
         case kTypeId::DOUBLE:
-            return tablevar{std::stod(s)};
+            return tablevar{parse_number<double>(s)};
         case kTypeId::BOOL:
             return tablevar{s == "true"};
         case kTypeId::STRING:
-            return tablevar{s};
+            return tablevar{std::string(s)};
         default:
             return tablevar{Null()};
     }
@@ -7,12 +7,13 @@
 #include <forward_list>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 
 using tablevar = std::variant<int32_t, float, double, bool, std::string, Null>;
 
 enum class kTypeId : uint8_t {INT = 0, FLOAT = 1, DOUBLE = 2, BOOL = 3, STRING = 4, NULLOBJ = 5};
 
-static std::unordered_map<std::string, uint8_t> kOperationsID = {
+static const std::unordered_map<std::string, uint8_t> kOperationsID = {
         {"=", 0}, {"!=", 1}, {">", 2}, {">=", 3}, {"<", 4}, {"<=", 5}
 };
 
@@ -34,7 +35,7 @@ public:
     Row() = default;
     Row(std::vector<tablevar> il);
     explicit Row(const size_t& n);
-    void print() const;
+    void print(std::ostream& out) const;
 
     tablevar& operator[](size_t index);
     const tablevar& operator[](size_t index) const;
@@ -48,4 +49,25 @@ public:
     bool check_condition_list(const std::vector<std::forward_list<Condition>>& check_list) const;
 };
 
-tablevar string_to_tablevar(const std::string& s, const kTypeId& type);
+// Numbers are parsed by prefix like std::stoi, throws std::runtime_error if there is no number
+tablevar string_to_tablevar(std::string_view s, const kTypeId& type);
+
+template<class T>
+bool check_operation(const T& lhs, const uint8_t& operation, const T& rhs) {
+    switch (operation) {
+        case 0:
+            return lhs == rhs;
+        case 1:
+            return lhs != rhs;
+        case 2:
+            return lhs > rhs;
+        case 3:
+            return lhs >= rhs;
+        case 4:
+            return lhs < rhs;
+        case 5:
+            return lhs <= rhs;
+        default:
+            return false;
+    }
+}
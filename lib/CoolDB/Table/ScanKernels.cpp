@@ -0,0 +1,177 @@
+#include "ScanKernels.h"
+
+#include <algorithm>
+#include <functional>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COOLDB_AVX2
+#endif
+
+const size_t kWordBits = 64;
+
+// ...............SCALAR
+
+template<class T, class Compare>
+void scalar_compare(const T* values, size_t begin, size_t n, const T& constant, uint64_t* out) {
+    // rows [begin, n), begin is a multiple of 64
+    for (size_t w = begin / kWordBits; w * kWordBits < n; ++w) {
+        const size_t first = w * kWordBits;
+        const size_t end = std::min(n, first + kWordBits);
+        uint64_t word = 0;
+        for (size_t i = first; i < end; ++i)
+            word |= static_cast<uint64_t>(Compare{}(values[i], constant)) << (i - first);
+        out[w] = word;
+    }
+}
+
+template<class T>
+void scalar_compare(const T* values, size_t begin, size_t n, const uint8_t& operation, const T& constant, uint64_t* out) {
+    switch (operation) {
+        case 0:
+            return scalar_compare<T, std::equal_to<T>>(values, begin, n, constant, out);
+        case 1:
+            return scalar_compare<T, std::not_equal_to<T>>(values, begin, n, constant, out);
+        case 2:
+            return scalar_compare<T, std::greater<T>>(values, begin, n, constant, out);
+        case 3:
+            return scalar_compare<T, std::greater_equal<T>>(values, begin, n, constant, out);
+        case 4:
+            return scalar_compare<T, std::less<T>>(values, begin, n, constant, out);
+        case 5:
+            return scalar_compare<T, std::less_equal<T>>(values, begin, n, constant, out);
+        default:
+            std::fill(out + begin / kWordBits, out + (n + kWordBits - 1) / kWordBits, 0);
+    }
+}
+
+// ...............AVX2
+
+#ifdef COOLDB_AVX2
+
+template<uint8_t Op>
+__attribute__((target("avx2"))) inline uint32_t avx2_mask(__m256i v, __m256i c) {
+    // 8 lanes
+    if constexpr (Op == 0)
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, c)));
+    else if constexpr (Op == 1)
+        return ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, c))) & 0xFF;
+    else if constexpr (Op == 2)
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, c)));
+    else if constexpr (Op == 3)
+        return ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(c, v))) & 0xFF;
+    else if constexpr (Op == 4)
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(c, v)));
+    else
+        return ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, c))) & 0xFF;
+}
+
+// ordered predicates except != to keep the NaN results of the scalar operators
+constexpr int avx2_predicate(uint8_t operation) {
+    constexpr int kPredicates[] = {_CMP_EQ_OQ, _CMP_NEQ_UQ, _CMP_GT_OQ, _CMP_GE_OQ, _CMP_LT_OQ, _CMP_LE_OQ};
+    return kPredicates[operation];
+}
+
+template<uint8_t Op>
+__attribute__((target("avx2"))) inline uint32_t avx2_mask(__m256 v, __m256 c) {
+    // 8 lanes
+    constexpr int kPredicate = avx2_predicate(Op);
+    return _mm256_movemask_ps(_mm256_cmp_ps(v, c, kPredicate));
+}
+
+template<uint8_t Op>
+__attribute__((target("avx2"))) inline uint32_t avx2_mask(__m256d v, __m256d c) {
+    // 4 lanes
+    constexpr int kPredicate = avx2_predicate(Op);
+    return _mm256_movemask_pd(_mm256_cmp_pd(v, c, kPredicate));
+}
+
+__attribute__((target("avx2"))) inline __m256i avx2_load(const int32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+__attribute__((target("avx2"))) inline __m256 avx2_load(const float* p) { return _mm256_loadu_ps(p); }
+__attribute__((target("avx2"))) inline __m256d avx2_load(const double* p) { return _mm256_loadu_pd(p); }
+
+__attribute__((target("avx2"))) inline __m256i avx2_broadcast(int32_t x) { return _mm256_set1_epi32(x); }
+__attribute__((target("avx2"))) inline __m256 avx2_broadcast(float x) { return _mm256_set1_ps(x); }
+__attribute__((target("avx2"))) inline __m256d avx2_broadcast(double x) { return _mm256_set1_pd(x); }
+
+template<class T, uint8_t Op>
+__attribute__((target("avx2"))) void avx2_compare(const T* values, size_t n, const T& constant, uint64_t* out) {
+    constexpr size_t kLanes = 32 / sizeof(T);
+    const auto c = avx2_broadcast(constant);
+    const size_t full = n / kWordBits;
+    for (size_t w = 0; w < full; ++w) {
+        const T* p = values + w * kWordBits;
+        uint64_t word = 0;
+        for (size_t k = 0; k < kWordBits / kLanes; ++k)
+            word |= static_cast<uint64_t>(avx2_mask<Op>(avx2_load(p + k * kLanes), c)) << (k * kLanes);
+        out[w] = word;
+    }
+}
+
+template<class T>
+__attribute__((target("avx2"))) void avx2_compare(const T* values, size_t n, const uint8_t& operation, const T& constant, uint64_t* out) {
+    switch (operation) {
+        case 0:
+            return avx2_compare<T, 0>(values, n, constant, out);
+        case 1:
+            return avx2_compare<T, 1>(values, n, constant, out);
+        case 2:
+            return avx2_compare<T, 2>(values, n, constant, out);
+        case 3:
+            return avx2_compare<T, 3>(values, n, constant, out);
+        case 4:
+            return avx2_compare<T, 4>(values, n, constant, out);
+        case 5:
+            return avx2_compare<T, 5>(values, n, constant, out);
+        default:
+            break;
+    }
+}
+
+#endif
+
+bool simd_supported() {
+#ifdef COOLDB_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+template<class T>
+void dispatch_compare(const T* values, size_t n, const uint8_t& operation, const T& constant, uint64_t* out) {
+#ifdef COOLDB_AVX2
+    if (simd_supported() && operation <= 5) {
+        // whole words go through AVX2, the tail through the scalar loop
+        avx2_compare(values, n, operation, constant, out);
+        scalar_compare(values, n / kWordBits * kWordBits, n, operation, constant, out);
+        return;
+    }
+#endif
+    scalar_compare(values, 0, n, operation, constant, out);
+}
+
+// ...............COMPARE
+
+void compare_values(const int32_t* values, size_t n, const uint8_t& operation, int32_t constant, uint64_t* out) {
+    dispatch_compare(values, n, operation, constant, out);
+}
+
+void compare_values(const float* values, size_t n, const uint8_t& operation, float constant, uint64_t* out) {
+    dispatch_compare(values, n, operation, constant, out);
+}
+
+void compare_values(const double* values, size_t n, const uint8_t& operation, double constant, uint64_t* out) {
+    dispatch_compare(values, n, operation, constant, out);
+}
+
+void compare_values(const uint8_t* values, size_t n, const uint8_t& operation, uint8_t constant, uint64_t* out) {
+    scalar_compare(values, 0, n, operation, constant, out);
+}
+
+void compare_values(const std::string* values, size_t n, const uint8_t& operation, const std::string& constant, uint64_t* out) {
+    scalar_compare(values, 0, n, operation, constant, out);
+}
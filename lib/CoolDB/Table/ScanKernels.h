@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Compare values[0..n) with a constant and write one result bit per value into out
+// (bit i of word i / 64, the bits after n are cleared).
+// int, float and double use AVX2 when the CPU supports it, the scalar loops are picked at runtime otherwise
+void compare_values(const int32_t* values, size_t n, const uint8_t& operation, int32_t constant, uint64_t* out);
+void compare_values(const float* values, size_t n, const uint8_t& operation, float constant, uint64_t* out);
+void compare_values(const double* values, size_t n, const uint8_t& operation, double constant, uint64_t* out);
+void compare_values(const uint8_t* values, size_t n, const uint8_t& operation, uint8_t constant, uint64_t* out);
+void compare_values(const std::string* values, size_t n, const uint8_t& operation, const std::string& constant, uint64_t* out);
+
+bool simd_supported();
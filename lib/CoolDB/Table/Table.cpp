@@ -1,8 +1,12 @@
 #include "Table.h"
+#include "HashJoin.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
 #include <exception>
 #include <iomanip>
 #include <regex>
+#include <utility>
 
 Table::Table(const std::string& name) : name_(name) {}
 
@@ -12,133 +16,283 @@ Table::~Table() { drop_table(); }
 
 Table::Table(const Table* other)
         : name_(other->name_), column_names_(other->column_names_),
-          column_types_(other->column_types_)
-          {}
+          column_types_(other->column_types_), column_lengths_(other->column_lengths_) {
+    for (const auto& type : column_types_)
+        columns_.emplace_back(type);
+}
 
-[[maybe_unused]]void Table::copy(const Table* other) { table_ = other->get_rows(); }
+Table::Table(const Table& other)
+        : columns_(other.columns_), rows_(other.rows_), name_(other.name_), column_names_(other.column_names_),
+          column_types_(other.column_types_), column_lengths_(other.column_lengths_),
+          primary_key_indexes_(other.primary_key_indexes_), primary_key_index_(other.primary_key_index_),
+          indexes_(other.indexes_) {}
+
+std::unique_ptr<Table> Table::next_version() {
+    // only statements that change a table look up its keys, readers of this version never do
+    PrimaryKeyIndex keys = std::exchange(primary_key_index_, PrimaryKeyIndex());
+    auto ret = std::make_unique<Table>(*this);
+    ret->primary_key_index_ = std::move(keys);
+    for (size_t column_index : ret->primary_key_index_.columns())
+        primary_key_index_.add_column(column_index);
+    return ret;
+}
+
+[[maybe_unused]]void Table::copy(const Table* other) {
+    columns_ = other->columns_;
+    rows_ = other->rows_;
+    rebuild_primary_index();
+    for (OrderedIndex& index : indexes_)
+        index.rebuild(columns_[index.column()]);
+}
 
 // ..................CREATE TABLE
 
-void Table::add_column(const std::string &type, const std::string &name) {
+void Table::add_column(const std::string &type, const std::string &name, size_t length) {
     if (type == "int")
-        column_types_.push_back(kTypeId::INT);
+        add_column(kTypeId::INT, name);
     else if (type == "float")
-        column_types_.push_back(kTypeId::FLOAT);
+        add_column(kTypeId::FLOAT, name);
     else if (type == "double")
-        column_types_.push_back(kTypeId::DOUBLE);
+        add_column(kTypeId::DOUBLE, name);
     else if (type == "bool")
-        column_types_.push_back(kTypeId::BOOL);
-    else if (std::regex_match(type, std::regex("varchar(\\([0-9]+\\))*")))
-        column_types_.push_back(kTypeId::STRING);
+        add_column(kTypeId::BOOL, name);
+    else if (std::smatch match; std::regex_match(type, match, std::regex("varchar(?:\\(([0-9]+)\\))?")))
+        add_column(kTypeId::STRING, name, match[1].matched ? std::stoull(match[1].str()) : length);
     else
         throw std::runtime_error{"Wrong type name"};
-    column_names_.push_back(name);
 }
 
-void Table::add_column(const kTypeId& type, const std::string& name) {
+void Table::add_column(const kTypeId& type, const std::string& name, size_t length) {
     column_types_.push_back(type);
+    column_lengths_.push_back(type == kTypeId::STRING ? length : 0);
     column_names_.push_back(name);
+    columns_.emplace_back(type);
+    for (size_t i = 0; i < rows_; ++i)
+        columns_.back().push_null();
 }
 
-void Table::add_primary_index(const size_t& index) { primary_key_indexes_.insert(index); }
+void Table::add_primary_index(const size_t& index) {
+    primary_key_indexes_.insert(index);
+    primary_key_index_.add_column(index);
+    rebuild_primary_index();
+}
+
+void Table::add_primary_index(const std::string& column_name) { add_primary_index(get_index_by_name(column_name)); }
 
-void Table::add_primary_index(const std::string& column_name) {
-    primary_key_indexes_.insert(get_index_by_name(column_name));
+void Table::check_length(size_t column_index, const tablevar& value) const {
+    const size_t length = column_lengths_[column_index];
+    if (length != 0 && value.index() == static_cast<size_t>(kTypeId::STRING) && std::get<std::string>(value).size() > length)
+        throw std::runtime_error{"Value too long for varchar(" + std::to_string(length) + ")"};
 }
 
+void Table::check_lengths(const std::vector<Column>& columns) const {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const size_t length = column_lengths_[i];
+        if (length != 0 && columns[i].max_length() > length)
+            throw std::runtime_error{"Value too long for varchar(" + std::to_string(length) + ")"};
+    }
+}
+
+void Table::rebuild_primary_index() {
+    primary_key_index_.clear();
+    if (primary_key_index_.empty())
+        return;
+    primary_key_index_.reserve(rows_);
+    for (size_t i = 0; i < rows_; ++i)
+        primary_key_index_.insert(primary_key_index_.key_of(columns_, i));
+}
+
+// ..............CREATE INDEX
+
+void Table::add_index(const std::string& name, size_t column_index) {
+    for (const OrderedIndex& index : indexes_)
+        if (index.name() == name)
+            throw std::runtime_error{"Index " + name + " already exists"};
+    indexes_.emplace_back(name, column_index, columns_[column_index]);
+}
+
+const OrderedIndex* Table::get_index(size_t column_index) const {
+    for (const OrderedIndex& index : indexes_)
+        if (index.column() == column_index)
+            return &index;
+    return nullptr;
+}
+
+const std::vector<OrderedIndex>& Table::get_indexes() const { return indexes_; }
+
 // ..............INSERT INTO
 
 [[maybe_unused]]void Table::insert_row(const std::vector<tablevar>& v) {
-    // check for unique primary keys
-    Row ins(v);
-    for (auto& row : table_) {
-        bool fl = false;
-        for (const auto& key_index : primary_key_indexes_)
-            if (row[key_index] != ins[key_index])
-                fl = true;
-        if (!fl)
-            throw std::runtime_error{"Already there's row with this primary key"};
-    }
+    insert_row(Row(v).align_to(size().first));
+}
+
+void Table::insert_row(const Row& ins) { insert_row(Row(ins)); }
 
+void Table::insert_row(Row&& ins) {
     // check for types
-    for (size_t i = 0; i < size().first; ++i)
-        if (v[i].index() != static_cast<int>(column_types_[i]) && v[i].index() != static_cast<int>(kTypeId::NULLOBJ))
+    for (int i = 0; i < size().first; ++i) {
+        if (ins[i].index() != static_cast<int>(column_types_[i]) && ins[i].index() != static_cast<int>(kTypeId::NULLOBJ))
             throw std::runtime_error{"Bad arguments order"};
+        check_length(i, ins[i]);
+    }
 
-    table_.emplace_back(ins.align_to(size().first));
+    // check for unique primary keys
+    if (!primary_key_index_.insert(ins))
+        throw std::runtime_error{"Already there's row with this primary key"};
+
+    for (size_t i = 0; i < columns_.size(); ++i)
+        columns_[i].push_back(std::move(ins[i]));
+    for (OrderedIndex& index : indexes_)
+        index.insert(columns_[index.column()], rows_);
+    ++rows_;
 }
 
-void Table::insert_row(const Row& ins) {
-    for (auto& row : table_) {
-        bool fl = true;
-        for (const auto& key_index : primary_key_indexes_)
-            if (row[key_index] == ins[key_index])
-                fl = false;
-        if (!fl)
-            throw std::runtime_error{"Already there's row with this primary key"};
+void Table::append_columns(std::vector<Column> columns) {
+    if (columns.size() != columns_.size())
+        throw std::runtime_error{"Bad arguments order"};
+    const size_t rows = columns.empty() ? 0 : columns[0].size();
+    for (size_t i = 0; i < columns.size(); ++i)
+        if (columns[i].type() != column_types_[i] || columns[i].size() != rows)
+            throw std::runtime_error{"Bad arguments order"};
+    check_lengths(columns);
+
+    // validate every new key before the rows are added, roll back on a repeat
+    if (!primary_key_index_.empty()) {
+        primary_key_index_.reserve(rows_ + rows);
+        for (size_t i = 0; i < rows; ++i) {
+            if (!primary_key_index_.insert(primary_key_index_.key_of(columns, i))) {
+                for (size_t j = 0; j < i; ++j)
+                    primary_key_index_.erase(columns, j);
+                throw std::runtime_error{"Already there's row with this primary key"};
+            }
+        }
     }
 
-    for (int i = 0; i < size().first; ++i)
-        if (ins[i].index() != static_cast<int>(column_types_[i]) && ins[i].index() != static_cast<int>(kTypeId::NULLOBJ))
-            throw std::runtime_error{"Bad arguments order"};
+    // the varchar columns of a bulk load into an empty table are encoded if they have few distinct strings
+    if (rows_ == 0) {
+        ThreadPool::instance().parallel_for(columns.size(), [&columns, rows](size_t i) {
+            columns[i].encode(rows / kDictionaryFraction);
+        });
+    }
+    for (size_t i = 0; i < columns.size(); ++i)
+        columns_[i].append(std::move(columns[i]));
+    // a sorted bulk build is cheaper than one insert per row once the batch isn't small
+    for (OrderedIndex& index : indexes_) {
+        if (rows > rows_ / 8)
+            index.rebuild(columns_[index.column()]);
+        else
+            for (size_t i = rows_; i < rows_ + rows; ++i)
+                index.insert(columns_[index.column()], i);
+    }
+    rows_ += rows;
+}
 
-    table_.emplace_back(ins);
+void Table::insert_columns(std::vector<Column> columns) {
+    clear_table();
+    append_columns(std::move(columns));
 }
 
 // .................UPDATE
 
 void Table::update(size_t row_index, size_t column_index, const tablevar& new_data) {
-    if (static_cast<int>(column_types_[column_index]) != new_data.index()) {
-        throw std::runtime_error{"Wrong type of new data"};
-    } else {
-        if (primary_key_indexes_.contains(column_index)) {
-            for (Row& row : table_) {
-                if (row[column_index] == new_data) {
-                    if (primary_key_indexes_.size() == 1)
-                        throw std::runtime_error{"Update failed, primary key repeats"};
-                    bool fl = false;
-                    for (size_t index : primary_key_indexes_) {
-                        if (index == column_index) continue;
-                        if (row[index] != table_[row_index][index]) {
-                            fl = true;
-                            break;
-                        }
-                    }
-                    if (fl)
-                        break;
-                    else
-                        throw std::runtime_error{"Update failed, primary key repeats"};
-
-                }
+    update_rows({row_index}, column_index, new_data);
+}
 
-            }
+void Table::update_rows(const std::vector<size_t>& row_indexes, size_t column_index, const tablevar& new_data) {
+    if (static_cast<int>(column_types_[column_index]) != new_data.index())
+        throw std::runtime_error{"Wrong type of new data"};
+    check_length(column_index, new_data);
+
+    if (primary_key_indexes_.contains(column_index)) {
+        const std::vector<size_t>& key_columns = primary_key_index_.columns();
+        const size_t key_position = std::find(key_columns.begin(), key_columns.end(), column_index) - key_columns.begin();
+        auto new_key = [this, key_position, &new_data](size_t row_index) {
+            tablekey key = primary_key_index_.key_of(columns_, row_index);
+            key[key_position] = new_data;
+            return key;
+        };
+        // the old keys of the batch leave first, so rows may take each other's keys.
+        // The cells aren't changed yet, on a repeat the old keys come back from them
+        for (size_t row_index : row_indexes)
+            primary_key_index_.erase(columns_, row_index);
+        size_t inserted = 0;
+        while (inserted < row_indexes.size() && primary_key_index_.insert(new_key(row_indexes[inserted])))
+            ++inserted;
+        if (inserted != row_indexes.size()) {
+            for (size_t i = 0; i < inserted; ++i)
+                primary_key_index_.erase(new_key(row_indexes[i]));
+            for (size_t row_index : row_indexes)
+                primary_key_index_.insert(primary_key_index_.key_of(columns_, row_index));
+            throw std::runtime_error{"Update failed, primary key repeats"};
         }
-        table_[row_index][column_index] = new_data;
+    }
+
+    Column& column = columns_[column_index];
+    const bool rebuild = row_indexes.size() > rows_ / 8;
+    for (OrderedIndex& index : indexes_)
+        if (index.column() == column_index && !rebuild)
+            for (size_t row_index : row_indexes)
+                index.erase(column, row_index);
+    column.set(row_indexes, new_data);
+    for (OrderedIndex& index : indexes_) {
+        if (index.column() != column_index)
+            continue;
+        if (rebuild)
+            index.rebuild(column);
+        else
+            for (size_t row_index : row_indexes)
+                index.insert(column, row_index);
     }
 }
 
 // ................DELETE
 
 void Table::clear_table() {
-    table_.clear();
+    for (Column& column : columns_)
+        column.clear();
+    rows_ = 0;
+    primary_key_index_.clear();
+    for (OrderedIndex& index : indexes_)
+        index.rebuild(columns_[index.column()]);
 }
 
 void Table::drop_table() {
-    table_.clear();
+    columns_.clear();
+    rows_ = 0;
     column_names_.clear();
     column_types_.clear();
+    column_lengths_.clear();
     primary_key_indexes_.clear();
+    primary_key_index_.drop();
+    indexes_.clear();
 }
 
 void Table::delete_row(size_t row_index) {
-    if (row_index >= table_.size())
+    if (row_index < rows_)
+        delete_rows({row_index});
+}
+
+void Table::delete_rows(const std::vector<size_t>& row_indexes) {
+    if (row_indexes.empty())
         return;
-    table_.erase(table_.begin() + row_index);
+    for (size_t row_index : row_indexes)
+        primary_key_index_.erase(columns_, row_index);
+    // like a big append, a big delete is cheaper to follow with a sorted bulk build
+    const bool rebuild = row_indexes.size() > rows_ / 8;
+    if (!rebuild)
+        for (OrderedIndex& index : indexes_)
+            index.erase_rows(columns_[index.column()], row_indexes);
+    for (Column& column : columns_)
+        column.erase(row_indexes);
+    rows_ -= row_indexes.size();
+    if (rebuild)
+        for (OrderedIndex& index : indexes_)
+            index.rebuild(columns_[index.column()]);
 }
 
 // ...............INFO
 
-std::pair<size_t, size_t> Table::size() const { return std::make_pair(column_names_.size(), table_.size()); }
+std::pair<size_t, size_t> Table::size() const { return std::make_pair(column_names_.size(), rows_); }
 
 [[maybe_unused]]void Table::rename(const std::string& new_name) { name_ = new_name; }
 
@@ -146,120 +300,140 @@ const std::string& Table::name() const { return name_; }
 
 const std::vector<kTypeId>& Table::get_types() const { return column_types_; }
 
+const std::vector<size_t>& Table::get_lengths() const { return column_lengths_; }
+
 const std::vector<std::string>& Table::get_names() const { return column_names_; }
 
 const std::unordered_set<size_t>& Table::get_primary_keys() const { return primary_key_indexes_; }
 
-const std::deque<Row>& Table::get_rows() const { return table_; }
-
-size_t Table::get_index_by_name(const std::string& name) const {
+size_t Table::get_index_by_name(std::string_view name) const {
     for (size_t i = 0; i < size().first; ++i)
         if (column_names_[i] == name)
             return i;
     return -1;
 }
 
-// ...................SHOW TABLE
-
-void Table::print() const {
-    std::cout << "Table: " << name_ << ", " << column_names_.size() << " cols " << table_.size() << " rows" << std::endl;
-    for (const auto& s : column_names_)
-        std::cout << std::setw(kPrintWidth) << s << '|';
-    std::cout << std::endl;
-    for (const auto& row : table_)
-        row.print();
+// ...............ROWS
 
-}
+const Column& Table::get_column(size_t column_index) const { return columns_[column_index]; }
 
-// ....................FIND ROWS
+tablevar Table::get(size_t row_index, size_t column_index) const { return columns_[column_index].get(row_index); }
 
- [[maybe_unused]]Table* Table::find(size_t column_index, const std::string& operation, const tablevar& var) const {
-    auto new_table = new Table(this);
-    for (const Row& row : table_)
-        if (row.check_condition(column_index, operation, var))
-            new_table->insert_row(row);
-
-    return new_table;
+Row Table::get_row(size_t row_index) const {
+    std::vector<tablevar> items;
+    items.reserve(columns_.size());
+    for (const Column& column : columns_)
+        items.push_back(column.get(row_index));
+    return items;
 }
 
-Table* Table::find(const std::vector<std::forward_list<Condition>>& check_list) const {
-    auto new_table = new Table(this);
-    for (const Row& row : table_)
-        if (row.check_condition_list(check_list))
-            new_table->insert_row(row);
-
-    return new_table;
+bool Table::check_condition(size_t row_index, size_t column_index, const uint8_t& operation, const tablevar& var) const {
+    return columns_[column_index].check_condition(row_index, operation, var);
 }
 
-// ....................SELECT COLS
-
-Table* Table::select(const std::vector<size_t>& column_indexes) const {
-    auto new_table = new Table(name_);
-    for (size_t ind : column_indexes) {
-        new_table->column_types_.push_back(column_types_[ind]);
-        new_table->column_names_.push_back(column_names_[ind]);
-    }
+// ...................SHOW TABLE
 
-    for (const Row& row : table_) {
-        Row r;
-        for (size_t ind : column_indexes)
-            r.push_back(row[ind]);
-        new_table->insert_row(r);
-    }
+void Table::print(std::ostream& out) const {
+    out << "Table: " << name_ << ", " << column_names_.size() << " cols " << rows_ << " rows" << std::endl;
+    for (const auto& s : column_names_)
+        out << std::setw(kPrintWidth) << s << '|';
+    out << std::endl;
+    for (size_t i = 0; i < rows_; ++i)
+        get_row(i).print(out);
 
-    return new_table;
 }
 
 // ..........................JOIN
 
-Table* Table::inner_join(const Table* other, size_t ind1, size_t ind2) const {
-    auto new_table = new Table(this);
-    for (size_t i = 0; i < other->size().first; ++i)
-        new_table->add_column(other->get_types()[i], other->get_names()[i]);
-
-    for (size_t i = 0; i < size().second; ++i) {
-        Row ins = table_[i];
-        for (size_t j = 0; j < other->size().second; ++j) {
-            if (table_[i][ind1] == other->get_rows()[j][ind2]) {
-                for (size_t k = 0; k < other->size().first; ++k) {
-                    ins.push_back(other->get_rows()[j][k]);
-                }
-                new_table->insert_row(ins);
-                ins = table_[i];
-            }
+bool Table::sorted_by(size_t column_index) const {
+    const Column& column = columns_[column_index];
+    for (size_t i = 1; i < rows_; ++i)
+        if (column.less(i, column, i - 1))
+            return false;
+    return true;
+}
+
+Table::joinpairs Table::hash_join(const Table* other, size_t ind1, size_t ind2, bool outer) const {
+    const Column& left = columns_[ind1];
+    const Column& right = other->columns_[ind2];
+    if (left.type() == right.type())
+        return partitioned_hash_join(left, right, outer);
+
+    // columns of different types only match on NULL keys, they keep the tablevar hash tables
+    joinpairs pairs;
+    if (other->rows_ <= rows_) {
+        // build on the right side, probe with the left one in row order
+        std::unordered_map<tablevar, std::vector<size_t>> build;
+        build.reserve(other->rows_);
+        for (size_t j = 0; j < other->rows_; ++j)
+            build[right.get(j)].push_back(j);
+
+        for (size_t i = 0; i < rows_; ++i) {
+            auto it = build.find(left.get(i));
+            if (it != build.end()) {
+                for (size_t j : it->second)
+                    pairs.emplace_back(i, j);
+            } else if (outer)
+                pairs.emplace_back(i, kNoMatch);
+        }
+    } else {
+        // build on the left side, probe with the right one and regroup the matches by left row
+        std::unordered_map<tablevar, std::vector<size_t>> build;
+        build.reserve(rows_);
+        for (size_t i = 0; i < rows_; ++i)
+            build[left.get(i)].push_back(i);
+
+        std::vector<std::vector<size_t>> matches(rows_);
+        for (size_t j = 0; j < other->rows_; ++j) {
+            auto it = build.find(right.get(j));
+            if (it != build.end())
+                for (size_t i : it->second)
+                    matches[i].push_back(j);
+        }
+
+        for (size_t i = 0; i < rows_; ++i) {
+            for (size_t j : matches[i])
+                pairs.emplace_back(i, j);
+            if (outer && matches[i].empty())
+                pairs.emplace_back(i, kNoMatch);
         }
     }
 
-    return new_table;
+    return pairs;
 }
 
-Table* Table::left_join(const Table* other, size_t ind1, size_t ind2) const {
-    auto new_table = new Table(this);
-    for (int i = 0; i < other->size().first; ++i)
-        new_table->add_column(other->get_types()[i], other->get_names()[i]);
-
-    for (size_t i = 0; i < size().second; ++i) {
-        Row ins = table_[i];
-        bool fl = false;
-        for (size_t j = 0; j < other->size().second; ++j) {
-            if (table_[i][ind1] == other->get_rows()[j][ind2]) {
-                fl = true;
-                for (size_t k = 0; k < other->size().first; ++k)
-                    ins.push_back(other->get_rows()[j][k]);
-                new_table->insert_row(ins);
-                ins = table_[i];
-            }
-        }
-        if (!fl) {
-            for (size_t j = this->size().first; j < new_table->size().first; ++j)
-                ins.push_back(Null());
-            new_table->insert_row(ins);
+Table::joinpairs Table::merge_join(const Table* other, size_t ind1, size_t ind2, bool outer) const {
+    // both sides must be sorted by the join columns
+    const Column& left = columns_[ind1];
+    const Column& right = other->columns_[ind2];
+    joinpairs pairs;
+    size_t i = 0;
+    size_t j = 0;
+    const size_t n = rows_;
+    const size_t m = other->rows_;
+    while (i < n) {
+        const size_t key = i;
+        while (j < m && right.less(j, left, key))
+            ++j;
+        size_t run_end = j;
+        while (run_end < m && right.equal(run_end, left, key))
+            ++run_end;
+
+        for (; i < n && left.equal(i, left, key); ++i) {
+            for (size_t k = j; k < run_end; ++k)
+                pairs.emplace_back(i, k);
+            if (outer && j == run_end)
+                pairs.emplace_back(i, kNoMatch);
         }
     }
 
-    return new_table;
+    return pairs;
 }
 
-Table* Table::right_join(const Table* other, size_t ind1, size_t ind2) const {
-    return other->left_join(this, ind2, ind1);
+Table::joinpairs Table::join_rows(const Table* other, size_t ind1, size_t ind2, bool outer) const {
+    // sort-merge needs no extra memory, so it wins whenever both inputs are already ordered,
+    // otherwise both sides are hash partitioned and joined partition by partition
+    if (sorted_by(ind1) && other->sorted_by(ind2))
+        return merge_join(other, ind1, ind2, outer);
+    return hash_join(other, ind1, ind2, outer);
 }
@@ -1,40 +1,85 @@
 #pragma once
 
 #include "Row.h"
+#include "PrimaryKeyIndex.h"
+#include "OrderedIndex.h"
+#include "Predicate.h"
 
-#include <deque>
+#include <memory>
 #include <unordered_set>
 
 class Table final {
+public:
+    // pairs of matching row indexes, second is kNoMatch for NULL padded rows
+    using joinpairs = std::vector<std::pair<size_t, size_t>>;
 private:
-    std::deque<Row> table_;
+    std::vector<Column> columns_;
+    size_t rows_ = 0;
     std::string name_;
     std::vector<std::string> column_names_;
     std::vector<kTypeId> column_types_;
+    // N of a varchar(N) column, 0 if its strings may be of any length
+    std::vector<size_t> column_lengths_;
     std::unordered_set<size_t> primary_key_indexes_;
+    PrimaryKeyIndex primary_key_index_;
+    std::vector<OrderedIndex> indexes_;
+
+    // throw std::runtime_error if a string is longer than its varchar(N) column allows
+    void check_length(size_t column_index, const tablevar& value) const;
+    void check_lengths(const std::vector<Column>& columns) const;
+
+    // JOIN ENGINES
+    bool sorted_by(size_t column_index) const;
+    joinpairs hash_join(const Table* other, size_t ind1, size_t ind2, bool outer) const;
+    joinpairs merge_join(const Table* other, size_t ind1, size_t ind2, bool outer) const;
 public:
     explicit Table(const std::string& name);
     ~Table();
 
     // COPY
+    // the columns of other without its rows, keys and indexes
     explicit Table(const Table* other);
+    // every row, key and index of other, the column chunks and index nodes are shared until one side changes them
+    Table(const Table& other);
+    // a copy to change while this table is still read. It takes over the primary key index,
+    // so this table must not be changed any more unless the copy is dropped and the index rebuilt
+    std::unique_ptr<Table> next_version();
+    void rebuild_primary_index();
     void copy(const Table* other);
 
     // CREATE TABLE
-    void add_column(const std::string& type, const std::string& name);
-    void add_column(const kTypeId& type, const std::string& name);
+    // type is int, float, double, bool, varchar or varchar(N), length is the N of a varchar without one
+    void add_column(const std::string& type, const std::string& name, size_t length = 0);
+    void add_column(const kTypeId& type, const std::string& name, size_t length = 0);
     void add_primary_index(const size_t& index);
     void add_primary_index(const std::string& column_name);
 
+    // CREATE INDEX
+    void add_index(const std::string& name, size_t column_index);
+    // the first index of the column, nullptr if there's none
+    const OrderedIndex* get_index(size_t column_index) const;
+    const std::vector<OrderedIndex>& get_indexes() const;
+
     // INSERT INTO
     void insert_row(const std::vector<tablevar>& ins);
     void insert_row(const Row& ins);
+    // the strings of ins are moved into the columns
+    void insert_row(Row&& ins);
+    // whole columns of new rows, e.g. the ones read by a binary @load or @copy.
+    // Nothing is inserted if a primary key repeats
+    void append_columns(std::vector<Column> columns);
+    // replaces all rows
+    void insert_columns(std::vector<Column> columns);
 
     // UPDATE TABLE
     void update(size_t row_index, size_t column_index, const tablevar& new_data);
+    // sets the cell of column_index in every row of row_indexes, nothing changes if a primary key would repeat
+    void update_rows(const std::vector<size_t>& row_indexes, size_t column_index, const tablevar& new_data);
 
     // DELETE
     void delete_row(size_t row_index);
+    // rows at the ascending, distinct row_indexes, the storage is compacted in one pass
+    void delete_rows(const std::vector<size_t>& row_indexes);
     void clear_table();
     void drop_table();
 
@@ -43,24 +88,22 @@ public:
     std::pair<size_t, size_t> size() const;
     void rename(const std::string& new_name);
     const std::vector<kTypeId>& get_types() const;
+    const std::vector<size_t>& get_lengths() const;
     const std::vector<std::string>& get_names() const;
     const std::unordered_set<size_t>& get_primary_keys() const;
-    const std::deque<Row>& get_rows() const;
-    size_t get_index_by_name(const std::string& name) const;
+    size_t get_index_by_name(std::string_view name) const;
 
-    // SHOW TABLE
-    void print() const;
-
-    // FIND ROWS
-    Table* find(size_t column_index, const std::string& operation, const tablevar& var) const;
-    Table* find(const std::vector<std::forward_list<Condition>>& check_list) const;
+    // ROWS
+    const Column& get_column(size_t column_index) const;
+    tablevar get(size_t row_index, size_t column_index) const;
+    Row get_row(size_t row_index) const;
+    bool check_condition(size_t row_index, size_t column_index, const uint8_t& operation, const tablevar& var) const;
 
-    // SELECT COLS
-    Table* select(const std::vector<size_t>& column_indexes) const;
+    // SHOW TABLE
+    void print(std::ostream& out) const;
 
     // JOIN
-    Table* inner_join(const Table* other, size_t ind1, size_t ind2) const;
-    Table* left_join(const Table* other, size_t ind1, size_t ind2) const;
-    Table* right_join(const Table* other, size_t ind1, size_t ind2) const;
+    // matching (row, other row) pairs in row order, with outer a row without a match is paired with kNoMatch
+    joinpairs join_rows(const Table* other, size_t ind1, size_t ind2, bool outer) const;
 
 };
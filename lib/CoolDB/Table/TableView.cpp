@@ -0,0 +1,187 @@
+#include "TableView.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <numeric>
+
+TableView::TableView(const Table* table) : name_(table->name()), sources_{{table, nullptr}}, rows_(table->size().second) {
+    for (size_t k = 0; k < table->size().first; ++k)
+        columns_.push_back({0, k});
+}
+
+TableView::TableView(const Table* table, std::vector<size_t> row_indexes) : TableView(table) {
+    rows_ = row_indexes.size();
+    sources_[0].rows_ = std::make_shared<const std::vector<size_t>>(std::move(row_indexes));
+}
+
+size_t TableView::base_row(const Source& source, size_t row_index) const {
+    if (source.rows_ == nullptr || row_index == kNoMatch)
+        return row_index;
+    return (*source.rows_)[row_index];
+}
+
+// ...............INFO
+
+const std::string& TableView::name() const { return name_; }
+
+std::pair<size_t, size_t> TableView::size() const { return std::make_pair(columns_.size(), rows_); }
+
+size_t TableView::get_index_by_name(std::string_view name) const {
+    for (size_t k = 0; k < columns_.size(); ++k)
+        if (get_name(k) == name)
+            return k;
+    return -1;
+}
+
+kTypeId TableView::get_type(size_t column_index) const {
+    const ViewColumn& column = columns_[column_index];
+    return sources_[column.source_].table_->get_types()[column.column_];
+}
+
+const std::string& TableView::get_name(size_t column_index) const {
+    const ViewColumn& column = columns_[column_index];
+    return sources_[column.source_].table_->get_names()[column.column_];
+}
+
+// ...............CELLS
+
+tablevar TableView::get(size_t row_index, size_t column_index) const {
+    const ViewColumn& column = columns_[column_index];
+    const Source& source = sources_[column.source_];
+    const size_t row = base_row(source, row_index);
+    if (row == kNoMatch)
+        return tablevar{Null()};
+    return source.table_->get(row, column.column_);
+}
+
+Row TableView::get_row(size_t row_index) const {
+    std::vector<tablevar> items;
+    items.reserve(columns_.size());
+    for (size_t k = 0; k < columns_.size(); ++k)
+        items.push_back(get(row_index, k));
+    return items;
+}
+
+const Column& TableView::base_column(size_t column_index) const {
+    const ViewColumn& column = columns_[column_index];
+    return sources_[column.source_].table_->get_column(column.column_);
+}
+
+size_t TableView::base_row(size_t row_index, size_t column_index) const {
+    return base_row(sources_[columns_[column_index].source_], row_index);
+}
+
+std::vector<size_t> TableView::base_rows(size_t column_index) const {
+    const Source& source = sources_[columns_[column_index].source_];
+    if (source.rows_ != nullptr)
+        return *source.rows_;
+    std::vector<size_t> rows(rows_);
+    std::iota(rows.begin(), rows.end(), size_t{0});
+    return rows;
+}
+
+bool TableView::check_condition(size_t row_index, size_t column_index, const uint8_t& operation, const tablevar& var) const {
+    const ViewColumn& column = columns_[column_index];
+    const Source& source = sources_[column.source_];
+    const size_t row = base_row(source, row_index);
+    if (row == kNoMatch)
+        return check_operation(tablevar{Null()}, operation, var);
+    return source.table_->check_condition(row, column.column_, operation, var);
+}
+
+// ...............COMPOSE
+
+TableView TableView::select_rows(const std::vector<size_t>& row_indexes) const {
+    TableView view = *this;
+    for (Source& source : view.sources_) {
+        auto rows = std::make_shared<std::vector<size_t>>(row_indexes.size());
+        for (size_t i = 0; i < row_indexes.size(); ++i)
+            (*rows)[i] = base_row(source, row_indexes[i]);
+        source.rows_ = std::move(rows);
+    }
+    view.rows_ = row_indexes.size();
+    return view;
+}
+
+TableView TableView::filter(std::vector<std::forward_list<Condition>> check_list) const {
+    // a view of one table with all its rows runs the compiled scan, indexes included
+    if (sources_.size() == 1 && sources_[0].rows_ == nullptr) {
+        for (auto& conditions : check_list)
+            for (Condition& condition : conditions)
+                condition.column_ = columns_[condition.column_].column_;
+        const Table* table = sources_[0].table_;
+        TableView view = *this;
+        view.sources_[0].rows_ = std::make_shared<const std::vector<size_t>>(
+                Predicate(table, std::move(check_list)).find_rows(rows_));
+        view.rows_ = view.sources_[0].rows_->size();
+        return view;
+    }
+
+    // otherwise every row is checked through the selections, morsels keep their matches in order
+    const size_t morsels = (rows_ + kMorselRows - 1) / kMorselRows;
+    std::vector<std::vector<size_t>> found(morsels);
+    ThreadPool::instance().parallel_for(morsels, [&](size_t morsel) {
+        for (size_t i = morsel * kMorselRows; i < std::min(rows_, (morsel + 1) * kMorselRows); ++i) {
+            for (const auto& conditions : check_list) {
+                bool flag = true;
+                for (const Condition& condition : conditions) {
+                    if (check_condition(i, condition.column_, condition.op_, condition.data_) == condition.not_) {
+                        flag = false;
+                        break;
+                    }
+                }
+                if (flag) {
+                    found[morsel].push_back(i);
+                    break;
+                }
+            }
+        }
+    });
+    std::vector<size_t> row_indexes;
+    for (const std::vector<size_t>& rows : found)
+        row_indexes.insert(row_indexes.end(), rows.begin(), rows.end());
+    return select_rows(row_indexes);
+}
+
+TableView TableView::project(const std::vector<size_t>& column_indexes) const {
+    TableView view = *this;
+    view.columns_.clear();
+    for (size_t k : column_indexes)
+        view.columns_.push_back(columns_[k]);
+    return view;
+}
+
+TableView TableView::concat(const std::vector<TableView>& views) const {
+    TableView view = *this;
+    for (const TableView& other : views)
+        view.rows_ += other.rows_;
+    for (size_t s = 0; s < sources_.size(); ++s) {
+        auto rows = std::make_shared<std::vector<size_t>>();
+        rows->reserve(view.rows_);
+        for (size_t i = 0; i < rows_; ++i)
+            rows->push_back(base_row(sources_[s], i));
+        for (const TableView& other : views)
+            for (size_t i = 0; i < other.rows_; ++i)
+                rows->push_back(other.base_row(other.sources_[s], i));
+        view.sources_[s].rows_ = std::move(rows);
+    }
+    return view;
+}
+
+TableView TableView::join(const TableView& right, const Table::joinpairs& pairs) const {
+    std::vector<size_t> left_rows;
+    std::vector<size_t> right_rows;
+    left_rows.reserve(pairs.size());
+    right_rows.reserve(pairs.size());
+    for (const auto& [i, j] : pairs) {
+        left_rows.push_back(i);
+        right_rows.push_back(j);
+    }
+
+    TableView view = select_rows(left_rows);
+    const TableView other = right.select_rows(right_rows);
+    for (const ViewColumn& column : other.columns_)
+        view.columns_.push_back({column.source_ + view.sources_.size(), column.column_});
+    view.sources_.insert(view.sources_.end(), other.sources_.begin(), other.sources_.end());
+    return view;
+}
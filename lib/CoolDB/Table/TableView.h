@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Table.h"
+
+#include <memory>
+
+// Result of a query that points into its base tables instead of copying their cells.
+// Every column of the view is a column of a base table read through a row selection of that table,
+// so filters and projections only build new selections. A view is valid while its base tables
+// are neither changed nor dropped
+class TableView final {
+private:
+    struct Source {
+        const Table* table_;
+        // rows of table_ in view order, kNoMatch gives NULL cells; nullptr stands for all rows in order
+        std::shared_ptr<const std::vector<size_t>> rows_;
+    };
+    struct ViewColumn {
+        size_t source_;
+        size_t column_;
+    };
+
+    std::string name_;
+    std::vector<Source> sources_;
+    std::vector<ViewColumn> columns_;
+    size_t rows_ = 0;
+
+    TableView() = default;
+    size_t base_row(const Source& source, size_t row_index) const;
+public:
+    // every row and column of table
+    explicit TableView(const Table* table);
+    // every column of table at the rows of row_indexes
+    TableView(const Table* table, std::vector<size_t> row_indexes);
+
+    // INFO
+    const std::string& name() const;
+    std::pair<size_t, size_t> size() const;
+    size_t get_index_by_name(std::string_view name) const;
+    kTypeId get_type(size_t column_index) const;
+    const std::string& get_name(size_t column_index) const;
+
+    // CELLS
+    tablevar get(size_t row_index, size_t column_index) const;
+    Row get_row(size_t row_index) const;
+    // the base table column behind column_index and the row of row_index in it, kNoMatch for NULL padding
+    const Column& base_column(size_t column_index) const;
+    size_t base_row(size_t row_index, size_t column_index) const;
+    // base_row of every row of the view
+    std::vector<size_t> base_rows(size_t column_index) const;
+    bool check_condition(size_t row_index, size_t column_index, const uint8_t& operation, const tablevar& var) const;
+
+    // COMPOSE
+    // the rows at row_indexes of this view, kNoMatch gives a NULL padded row
+    TableView select_rows(const std::vector<size_t>& row_indexes) const;
+    // the rows for which check_list holds, its conditions refer to the columns of this view
+    TableView filter(std::vector<std::forward_list<Condition>> check_list) const;
+    // the columns at column_indexes, in that order
+    TableView project(const std::vector<size_t>& column_indexes) const;
+    // the rows of this view followed by the ones of views, which have the same tables and columns
+    TableView concat(const std::vector<TableView>& views) const;
+    // the columns of this view, then the ones of right, for each (row, right row) of pairs
+    TableView join(const TableView& right, const Table::joinpairs& pairs) const;
+};
@@ -0,0 +1,110 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+// set on the workers and on a caller inside parallel_for, nested loops run inline
+static thread_local bool in_pool = false;
+
+ThreadPool::ThreadPool(size_t threads) { start(threads); }
+
+ThreadPool::~ThreadPool() { stop(); }
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+size_t ThreadPool::threads() const { return worker_count_ + 1; }
+
+void ThreadPool::resize(size_t threads) {
+    std::lock_guard job(job_mutex_);
+    stop();
+    start(threads);
+}
+
+// ...............WORKERS
+
+void ThreadPool::start(size_t threads) {
+    stop_ = false;
+    for (size_t i = 1; i < threads; ++i)
+        workers_.emplace_back(&ThreadPool::work_loop, this, generation_);
+    worker_count_ = workers_.size();
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (std::thread& worker : workers_)
+        worker.join();
+    workers_.clear();
+    worker_count_ = 0;
+}
+
+void ThreadPool::work_loop(uint64_t seen) {
+    in_pool = true;
+    std::unique_lock lock(mutex_);
+    while (true) {
+        start_cv_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+        if (stop_)
+            return;
+        seen = generation_;
+        const std::function<void(size_t)>& task = *task_;
+        const size_t count = count_;
+        lock.unlock();
+        run_morsels(task, count);
+        lock.lock();
+        if (++finished_ == worker_count_)
+            done_cv_.notify_all();
+    }
+}
+
+void ThreadPool::run_morsels(const std::function<void(size_t)>& task, size_t count) {
+    for (size_t k = next_.fetch_add(1); k < count; k = next_.fetch_add(1)) {
+        try {
+            task(k);
+        } catch (...) {
+            std::lock_guard lock(mutex_);
+            if (!error_)
+                error_ = std::current_exception();
+            // the rest of the morsels are skipped
+            next_ = count;
+        }
+    }
+}
+
+// ...............JOBS
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& task) {
+    std::unique_lock job(job_mutex_, std::defer_lock);
+    // workers_ is only looked at under job_mutex_, resize() swaps it under that lock
+    if (count <= 1 || in_pool || !job.try_lock() || workers_.empty()) {
+        for (size_t k = 0; k < count; ++k)
+            task(k);
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        task_ = &task;
+        count_ = count;
+        next_ = 0;
+        finished_ = 0;
+        error_ = nullptr;
+        ++generation_;
+    }
+    start_cv_.notify_all();
+    in_pool = true;
+    run_morsels(task, count);
+    in_pool = false;
+
+    std::unique_lock lock(mutex_);
+    // every worker checks in, even one that wakes up after the morsels ran out, so none sees a stale task
+    done_cv_.wait(lock, [this] { return finished_ == worker_count_; });
+    task_ = nullptr;
+    if (error_)
+        std::rethrow_exception(std::exchange(error_, nullptr));
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// rows a thread takes at once in a parallel scan, a multiple of 64 so no two threads write one bitmap word
+const size_t kMorselRows = size_t{1} << 15;
+
+// Workers for morsel-driven scans: parallel_for hands the morsels [0, count) out one at a time
+// through a shared counter, so a thread that finishes early takes the next morsel instead of idling.
+// The calling thread works too, the pool keeps threads() - 1 workers
+class ThreadPool final {
+private:
+    std::vector<std::thread> workers_;
+    // workers_.size(), readable without job_mutex_ while @threads resizes the pool
+    std::atomic<size_t> worker_count_ = 0;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    // one job at a time, a second caller runs its loop alone
+    std::mutex job_mutex_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t count_ = 0;
+    std::atomic<size_t> next_ = 0;
+    size_t finished_ = 0;
+    uint64_t generation_ = 0;
+    std::exception_ptr error_;
+    bool stop_ = false;
+
+    // seen is the last job started before the worker, it waits for the next one
+    void work_loop(uint64_t seen);
+    void run_morsels(const std::function<void(size_t)>& task, size_t count);
+    void start(size_t threads);
+    void stop();
+public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // shared by every Table, sized to the hardware until set by @threads
+    static ThreadPool& instance();
+
+    size_t threads() const;
+    void resize(size_t threads);
+
+    // calls task(k) for each k in [0, count) and returns when all are done.
+    // The first exception thrown by a task is rethrown here. Calls made from inside a task run inline
+    void parallel_for(size_t count, const std::function<void(size_t)>& task);
+};
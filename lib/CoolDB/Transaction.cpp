@@ -0,0 +1,60 @@
+#include "Transaction.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// first byte of a transaction record, a logged statement starts with a letter or '@'
+const char kTransactionMark = '\0';
+
+void Transaction::insert(std::string_view table, std::vector<Column> rows, const std::string& statement) {
+    std::vector<Step>& steps = tables_.try_emplace(std::string(table)).first->second;
+    if (!steps.empty() && steps.back().statement_.empty()) {
+        for (size_t i = 0; i < rows.size(); ++i)
+            steps.back().rows_[i].append(std::move(rows[i]));
+    } else {
+        steps.push_back({std::move(rows), {}});
+    }
+    statements_.push_back(statement);
+}
+
+void Transaction::change(std::string_view table, const std::string& statement) {
+    tables_.try_emplace(std::string(table)).first->second.push_back({{}, statement});
+    statements_.push_back(statement);
+}
+
+bool Transaction::empty() const { return statements_.empty(); }
+
+std::map<std::string, std::vector<Transaction::Step>, std::less<>>& Transaction::tables() { return tables_; }
+
+// ..................LOG
+
+// kTransactionMark, then every statement as a u32 length and its bytes
+std::string Transaction::record() const {
+    std::string ret(1, kTransactionMark);
+    for (const std::string& statement : statements_) {
+        const auto length = static_cast<uint32_t>(statement.size());
+        ret.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        ret += statement;
+    }
+    return ret;
+}
+
+bool Transaction::is_record(std::string_view record) { return !record.empty() && record[0] == kTransactionMark; }
+
+std::vector<std::string> Transaction::statements(std::string_view record) {
+    std::vector<std::string> ret;
+    size_t pos = 1;
+    while (pos < record.size()) {
+        uint32_t length;
+        if (record.size() - pos < sizeof(length))
+            throw std::runtime_error{"Wrong transaction record"};
+        std::memcpy(&length, record.data() + pos, sizeof(length));
+        pos += sizeof(length);
+        if (record.size() - pos < length)
+            throw std::runtime_error{"Wrong transaction record"};
+        ret.emplace_back(record.substr(pos, length));
+        pos += length;
+    }
+    return ret;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Table/Column.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Changes of a transaction between BEGIN and COMMIT, no table sees them before COMMIT.
+// The rows of INSERTs in a row into one table are gathered into one batch of columns,
+// an UPDATE or DELETE is kept as its statement and runs at COMMIT in its place.
+// The whole transaction goes to the log as one record of its statements
+class Transaction final {
+public:
+    // rows to add to a table or a statement to run on it
+    struct Step {
+        std::vector<Column> rows_;
+        // the UPDATE or DELETE, empty for rows
+        std::string statement_;
+    };
+private:
+    // by table name, so COMMIT takes the tables in name order
+    std::map<std::string, std::vector<Step>, std::less<>> tables_;
+    std::vector<std::string> statements_;
+public:
+    // an INSERT whose rows are already typed like the columns of table
+    void insert(std::string_view table, std::vector<Column> rows, const std::string& statement);
+    // an UPDATE or DELETE of table
+    void change(std::string_view table, const std::string& statement);
+
+    bool empty() const;
+    std::map<std::string, std::vector<Step>, std::less<>>& tables();
+
+    // LOG
+    // the statements as one log record
+    std::string record() const;
+    // whether a log record is one of a transaction rather than a single statement
+    static bool is_record(std::string_view record);
+    // statements of a record made by record(), throws std::runtime_error if it's cut short
+    static std::vector<std::string> statements(std::string_view record);
+};
@@ -1,9 +1,54 @@
 #include "lib/CoolDB/CoolDB.h"
+#include "lib/CoolDB/Server/Server.h"
 
-int main() {
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+static Server* server = nullptr;
+
+static void stop_server(int) { server->stop(); }
+
+// main                                 statements from the console
+// main --serve ADDRESS [--workers N]   statements of clients, see Server.h
+int main(int argc, char** argv) {
 
     CoolDB db;
-    db.start_console();
+    if (argc == 1) {
+        db.start_console();
+        return 0;
+    }
+
+    std::string address;
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--serve") && i + 1 < argc) {
+            address = argv[++i];
+        } else if (!std::strcmp(argv[i], "--workers") && i + 1 < argc) {
+            workers = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            address.clear();
+            break;
+        }
+    }
+    if (address.empty() || workers == 0) {
+        std::cerr << "usage: main [--serve unix:<path>|tcp:<port> [--workers N]]\n";
+        return 1;
+    }
+    try {
+        Server instance(db, address, workers);
+        server = &instance;
+        std::signal(SIGINT, stop_server);
+        std::signal(SIGTERM, stop_server);
+        std::cout << "Listening on " << address << std::endl;
+        instance.run();
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+    } catch (const std::exception& e) {
+        std::cerr << '@' << e.what() << '\n';
+        return 1;
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,82 @@
+#include "../lib/CoolDB/CoolDB.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// cooldb_bench_group [-n rows] [-q queries] [-t threads]
+// Fills a table of n rows (2M by default) with keys of 10, 100 ... 1M distinct values, then times
+// SELECT key, COUNT(*), SUM, MIN, MAX, AVG ... GROUP BY key for each of them. LIMIT 1 keeps printing
+// the groups out of the time, the aggregation still reads every row
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+    size_t rows = 2'000'000;
+    size_t queries = 3;
+    size_t threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i + 1 < argc) {
+            rows = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-q") && i + 1 < argc) {
+            queries = std::max(1ul, std::stoul(argv[++i]));
+        } else if (!std::strcmp(argv[i], "-t") && i + 1 < argc) {
+            threads = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "usage: cooldb_bench_group [-n rows] [-q queries] [-t threads]\n";
+            return 1;
+        }
+    }
+    const std::vector<size_t> groups = {10, 100, 1'000, 10'000, 100'000, 1'000'000};
+
+    CoolDB db;
+    Session session;
+    std::ostringstream out;
+    if (threads != 0)
+        db.execute("@threads " + std::to_string(threads), out, session);
+    std::string create = "CREATE TABLE bench (id int, value int";
+    for (size_t g : groups)
+        create += ", g" + std::to_string(g) + " int";
+    db.execute(create + ", PRIMARY KEY (id));", out, session);
+    std::mt19937 random(42);
+    for (size_t first = 0; first < rows; first += 1000) {
+        std::string line = "INSERT INTO bench VALUES ";
+        for (size_t id = first; id < std::min(rows, first + 1000); ++id) {
+            if (id != first)
+                line += ", ";
+            line += '(' + std::to_string(id) + ", " + std::to_string(random() % 1000);
+            for (size_t g : groups)
+                line += ", " + std::to_string(random() % g);
+            line += ')';
+        }
+        db.execute(line + ';', out, session);
+    }
+    if (!out.str().empty()) {
+        std::cerr << out.str();
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    for (size_t g : groups) {
+        const std::string key = "g" + std::to_string(g);
+        const std::string line = "SELECT " + key + ", COUNT(*), SUM(value), MIN(value), MAX(value), AVG(value) "
+                                 "FROM bench GROUP BY " + key + " LIMIT 1;";
+        std::ostringstream result;
+        const auto start = clock::now();
+        for (size_t k = 0; k < queries; ++k) {
+            result.str({});
+            db.execute(line, result, session);
+        }
+        const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / queries;
+        if (result.str().starts_with('@')) {
+            std::cerr << result.str();
+            return 1;
+        }
+        std::cout << "rows: " << rows << ", groups: " << g << ", time: " << ms << " ms, rows/s: "
+                  << static_cast<size_t>(rows / ms * 1000) << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "../lib/CoolDB/CoolDB.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// cooldb_bench_index [-n rows] [-q queries]
+// Fills a table of n rows (1M by default) whose year column is random, then runs q range SELECTs
+// (WHERE year >= a AND year < b) of a few selectivities before and after CREATE INDEX on year,
+// and prints the average time of one query each way. The counts found both ways must agree
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+    size_t rows = 1'000'000;
+    size_t queries = 20;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i + 1 < argc) {
+            rows = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-q") && i + 1 < argc) {
+            queries = std::max(1ul, std::stoul(argv[++i]));
+        } else {
+            std::cerr << "usage: cooldb_bench_index [-n rows] [-q queries]\n";
+            return 1;
+        }
+    }
+    // years are spread over [0, kYears)
+    constexpr int kYears = 100'000;
+
+    CoolDB db;
+    Session session;
+    std::ostringstream out;
+    db.execute("CREATE TABLE bench (id int, year int, score double, PRIMARY KEY (id));", out, session);
+    std::mt19937 random(42);
+    for (size_t first = 0; first < rows; first += 1000) {
+        std::string line = "INSERT INTO bench VALUES ";
+        for (size_t id = first; id < std::min(rows, first + 1000); ++id) {
+            if (id != first)
+                line += ", ";
+            line += '(' + std::to_string(id) + ", " + std::to_string(random() % kYears) + ", 1.5)";
+        }
+        db.execute(line + ';', out, session);
+    }
+    if (!out.str().empty()) {
+        std::cerr << out.str();
+        return 1;
+    }
+
+    // the widths of the ranges, as parts of all the years
+    const std::vector<double> fractions = {0.0001, 0.001, 0.01, 0.1};
+    // the output of every query, the ones with the index must be the same
+    auto run = [&](double fraction, std::vector<std::string>& results) {
+        const int width = std::max(1, static_cast<int>(fraction * kYears));
+        std::mt19937 ranges(7);
+        const auto start = clock::now();
+        for (size_t k = 0; k < queries; ++k) {
+            const int from = static_cast<int>(ranges() % (kYears - width));
+            std::ostringstream result;
+            db.execute("SELECT COUNT(*) FROM bench WHERE year >= " + std::to_string(from) +
+                       " AND year < " + std::to_string(from + width) + ';', result, session);
+            results.push_back(result.str());
+        }
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count() / queries;
+    };
+    std::vector<double> scans;
+    std::vector<std::string> scanned;
+    for (double fraction : fractions)
+        scans.push_back(run(fraction, scanned));
+    db.execute("CREATE INDEX year_index ON bench (year);", out, session);
+    std::vector<std::string> indexed;
+    std::cout << std::fixed << std::setprecision(3);
+    for (size_t f = 0; f < fractions.size(); ++f) {
+        const double ms = run(fractions[f], indexed);
+        std::cout << "rows: " << rows << ", selectivity: " << fractions[f] * 100 << "%, scan: " << scans[f]
+                  << " ms, index: " << ms << " ms, speedup: " << scans[f] / ms << "x\n";
+    }
+    if (scanned != indexed || !out.str().empty()) {
+        std::cerr << "@The index and the scan found different rows\n" << out.str();
+        return 1;
+    }
+    return 0;
+}
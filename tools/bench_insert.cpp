@@ -0,0 +1,68 @@
+#include "../lib/CoolDB/CoolDB.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// cooldb_bench_insert [-b rows per INSERT] [-w name width] [rows...]
+// Fills a table with a primary key by INSERTs of b rows, for every size of the list (10k, 100k and 1M by default),
+// and prints the rows inserted per second. Every row is checked against the primary key index.
+// With -w the name column is a varchar(w) of distinct strings of w characters, which isn't dictionary encoded;
+// strings past 15 characters don't fit in a std::string and cost an allocation each
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+    size_t batch = 1000;
+    size_t width = 0;
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+            batch = std::max(1ul, std::stoul(argv[++i]));
+        else if (!std::strcmp(argv[i], "-w") && i + 1 < argc)
+            width = std::max(8ul, std::stoul(argv[++i]));
+        else
+            sizes.push_back(std::stoul(argv[i]));
+    }
+    if (sizes.empty())
+        sizes = {10'000, 100'000, 1'000'000};
+
+    std::cout << std::fixed << std::setprecision(3);
+    for (size_t rows : sizes) {
+        CoolDB db;
+        Session session;
+        std::ostringstream out;
+        const size_t length = width == 0 ? 16 : width;
+        db.execute("CREATE TABLE bench (id int, name varchar(" + std::to_string(length) +
+                   "), score double, PRIMARY KEY (id));", out, session);
+
+        // the statements are made before the clock starts, only running them is timed
+        std::vector<std::string> statements;
+        for (size_t first = 0; first < rows; first += batch) {
+            std::string line = "INSERT INTO bench VALUES ";
+            for (size_t id = first; id < std::min(rows, first + batch); ++id) {
+                if (id != first)
+                    line += ", ";
+                std::string name = "row" + std::to_string(width == 0 ? id % 1000 : id);
+                if (width != 0)
+                    name.resize(width, 'x');
+                line += '(' + std::to_string(id) + ", '" + name + "', " + std::to_string(id % 100) + ".5)";
+            }
+            statements.push_back(line + ';');
+        }
+        const auto start = clock::now();
+        for (const std::string& line : statements)
+            db.execute(line, out, session);
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        if (!out.str().empty()) {
+            std::cerr << out.str();
+            return 1;
+        }
+        std::cout << "rows: " << rows << (width == 0 ? "" : ", width: " + std::to_string(width))
+                  << ", time: " << seconds << " s, rows/s: " << static_cast<size_t>(rows / seconds) << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "../lib/CoolDB/CoolDB.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// cooldb_bench_join [-n rows] [-q queries] [threads...]
+// Fills two tables of n rows (2M by default) whose join keys are shuffled, then times an INNER and a LEFT JOIN
+// of them with every thread count of the list (1, 4, 16 and the hardware ones by default), set by @threads.
+// Every thread count must find the same counts, the speedup is over the first one
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+    size_t rows = 2'000'000;
+    size_t queries = 3;
+    std::vector<size_t> thread_counts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+            rows = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "-q") && i + 1 < argc)
+            queries = std::max(1ul, std::stoul(argv[++i]));
+        else
+            thread_counts.push_back(std::max(1ul, std::stoul(argv[i])));
+    }
+    if (thread_counts.empty())
+        thread_counts = {1, 4, 16, std::max<size_t>(1, std::thread::hardware_concurrency())};
+
+    CoolDB db;
+    Session session;
+    std::ostringstream out;
+    db.execute("CREATE TABLE orders (id int, customer int, PRIMARY KEY (id));", out, session);
+    db.execute("CREATE TABLE customers (id int, zone int, PRIMARY KEY (id));", out, session);
+    // the keys of both tables in random order, a quarter of the orders has no customer
+    std::vector<size_t> keys(rows);
+    std::mt19937 random(42);
+    for (size_t k = 0; k < rows; ++k)
+        keys[k] = k;
+    std::shuffle(keys.begin(), keys.end(), random);
+    for (size_t first = 0; first < rows; first += 1000) {
+        std::string orders = "INSERT INTO orders VALUES ";
+        std::string customers = "INSERT INTO customers VALUES ";
+        for (size_t k = first; k < std::min(rows, first + 1000); ++k) {
+            if (k != first) {
+                orders += ", ";
+                customers += ", ";
+            }
+            orders += '(' + std::to_string(k) + ", " + std::to_string(keys[k] + rows / 4) + ')';
+            customers += '(' + std::to_string(keys[rows - 1 - k]) + ", " + std::to_string(k % 100) + ')';
+        }
+        db.execute(orders + ';', out, session);
+        db.execute(customers + ';', out, session);
+    }
+    if (!out.str().empty()) {
+        std::cerr << out.str();
+        return 1;
+    }
+
+    const std::vector<std::string> joins = {"JOIN", "LEFT JOIN"};
+    std::vector<std::string> counts(joins.size());
+    std::vector<double> first_ms(joins.size());
+    std::cout << std::fixed << std::setprecision(3);
+    for (size_t threads : thread_counts) {
+        db.execute("@threads " + std::to_string(threads), out, session);
+        for (size_t j = 0; j < joins.size(); ++j) {
+            const std::string line = "SELECT COUNT(*) FROM orders " + joins[j] +
+                                     " customers ON orders.customer = customers.id;";
+            std::ostringstream result;
+            const auto start = clock::now();
+            for (size_t k = 0; k < queries; ++k) {
+                result.str({});
+                db.execute(line, result, session);
+            }
+            const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / queries;
+            if (counts[j].empty()) {
+                counts[j] = result.str();
+                first_ms[j] = ms;
+            }
+            if (result.str() != counts[j] || !out.str().empty()) {
+                std::cerr << "@The counts differ with " << threads << " threads\n" << out.str() << result.str();
+                return 1;
+            }
+            std::cout << "rows: " << rows << ", " << joins[j] << ", threads: " << threads << ", time: " << ms
+                      << " ms, speedup: " << first_ms[j] / ms << "x\n";
+        }
+    }
+    return 0;
+}
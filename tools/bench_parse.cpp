@@ -0,0 +1,75 @@
+#include "../lib/CoolDB/Parser/Parser.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// cooldb_bench_parse [-f file] [-n statements] [-r rows per INSERT]
+// Parses the statements of the file (../Data/sql.txt by default) over and over until n of them are parsed
+// and prints the statements and megabytes parsed per second. With -r the rows of every INSERT are repeated
+// r times first, as in a bulk load. Only the parser runs, nothing is executed
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+    std::string path = "../Data/sql.txt";
+    size_t count = 1'000'000;
+    size_t repeat = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-f") && i + 1 < argc) {
+            path = argv[++i];
+        } else if (!std::strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-r") && i + 1 < argc) {
+            repeat = std::max(1ul, std::stoul(argv[++i]));
+        } else {
+            std::cerr << "usage: cooldb_bench_parse [-f file] [-n statements] [-r rows per INSERT]\n";
+            return 1;
+        }
+    }
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "@Can't open " << path << '\n';
+        return 1;
+    }
+    std::vector<std::string> statements;
+    for (std::string line; std::getline(file, line);) {
+        if (line.empty())
+            continue;
+        const size_t values = line.find("VALUES ");
+        if (line.starts_with("INSERT") && values != std::string::npos && repeat > 1) {
+            // the row list without its ; is written repeat times
+            const std::string rows = line.substr(values + 7, line.size() - values - 8);
+            line.resize(values + 7);
+            for (size_t k = 0; k < repeat; ++k)
+                line += (k == 0 ? "" : ", ") + rows;
+            line += ';';
+        }
+        statements.push_back(line);
+    }
+    if (statements.empty()) {
+        std::cerr << "@No statements in " << path << '\n';
+        return 1;
+    }
+
+    size_t bytes = 0;
+    const auto start = clock::now();
+    for (size_t k = 0; k < count; ++k) {
+        const std::string& line = statements[k % statements.size()];
+        try {
+            Parser(line).parse();
+        } catch (const std::runtime_error& e) {
+            std::cerr << '@' << e.what() << ": " << line << '\n';
+            return 1;
+        }
+        bytes += line.size();
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "statements: " << count << ", time: " << seconds << " s, statements/s: "
+              << static_cast<size_t>(count / seconds) << ", MB/s: " << bytes / seconds / 1e6 << '\n';
+    return 0;
+}
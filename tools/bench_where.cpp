@@ -0,0 +1,96 @@
+#include "../lib/CoolDB/CoolDB.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// cooldb_bench_where [-n rows] [-q queries]
+// Fills a table of n rows (1M by default) with random zones, scores and names, then times SELECT COUNT(*),
+// UPDATE and DELETE with a few WHERE clauses, q statements each, and prints the rows scanned per second.
+// An UPDATE sets the hits column, which no clause reads, so it changes the same rows every time.
+// Every DELETE removes another range of ids, the last line counts what is left
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+    size_t rows = 1'000'000;
+    size_t queries = 10;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i + 1 < argc) {
+            rows = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-q") && i + 1 < argc) {
+            queries = std::max(1ul, std::stoul(argv[++i]));
+        } else {
+            std::cerr << "usage: cooldb_bench_where [-n rows] [-q queries]\n";
+            return 1;
+        }
+    }
+
+    CoolDB db;
+    Session session;
+    std::ostringstream out;
+    db.execute("CREATE TABLE bench (id int, zone int, score double, name varchar(8), flag bool, "
+               "hits int, PRIMARY KEY (id));", out, session);
+    std::mt19937 random(42);
+    for (size_t first = 0; first < rows; first += 1000) {
+        std::string line = "INSERT INTO bench VALUES ";
+        for (size_t id = first; id < std::min(rows, first + 1000); ++id) {
+            if (id != first)
+                line += ", ";
+            line += '(' + std::to_string(id) + ", " + std::to_string(random() % 100) + ", " +
+                    std::to_string(random() % 10'000) + ".25, 'n" + std::to_string(random() % 5'000) + "', " +
+                    (random() % 2 == 0 ? "true" : "false") + ", 0)";
+        }
+        db.execute(line + ';', out, session);
+    }
+    if (!out.str().empty()) {
+        std::cerr << out.str();
+        return 1;
+    }
+
+    const std::vector<std::string> wheres = {
+        "zone = 3",
+        "score > 5000.5 AND zone < 50",
+        "name = 'n42'",
+        // AND binds tighter than OR
+        "score > 50 AND zone = 3 OR name = 'n7' AND id < 1000",
+        "NOT flag = true AND zone >= 90",
+    };
+    std::cout << std::fixed << std::setprecision(3);
+    // the average time of q statements made by make(k), each scans every row left in the table
+    auto run = [&](const std::string& kind, const std::string& where, auto make) {
+        std::ostringstream result;
+        const auto start = clock::now();
+        for (size_t k = 0; k < queries; ++k)
+            db.execute(make(k), result, session);
+        const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / queries;
+        if (result.str().find('@') != std::string::npos) {
+            std::cerr << result.str();
+            return false;
+        }
+        std::cout << kind << " WHERE " << where << ", time: " << ms << " ms, rows/s: "
+                  << static_cast<size_t>(rows / ms * 1000) << '\n';
+        return true;
+    };
+    for (const std::string& where : wheres)
+        if (!run("SELECT", where, [&](size_t) { return "SELECT COUNT(*) FROM bench WHERE " + where + ';'; }))
+            return 1;
+    for (const std::string& where : wheres)
+        if (!run("UPDATE", where, [&](size_t) { return "UPDATE bench SET hits = 1 WHERE " + where + ';'; }))
+            return 1;
+    // a thousandth of the ids per DELETE, the table barely shrinks
+    const size_t width = std::max<size_t>(1, rows / 1000);
+    const bool deleted = run("DELETE", "id >= a AND id < a + " + std::to_string(width), [&](size_t k) {
+        return "DELETE FROM bench WHERE id >= " + std::to_string(k * width) + " AND id < " +
+               std::to_string((k + 1) * width) + ';';
+    });
+    if (!deleted)
+        return 1;
+    std::ostringstream left;
+    db.execute("SELECT COUNT(*) FROM bench;", left, session);
+    std::cout << left.str();
+    return 0;
+}
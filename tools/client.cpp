@@ -0,0 +1,32 @@
+#include "../lib/CoolDB/Server/Protocol.h"
+
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+// cooldb_client ADDRESS
+// sends each line of the input to the server as a statement and prints what it answers
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "usage: cooldb_client unix:<path>|tcp:<port>\n";
+        return 1;
+    }
+    try {
+        const int fd = connect_to(argv[1]);
+        std::string line;
+        std::string response;
+        while (std::getline(std::cin, line)) {
+            if (line.empty())
+                continue;
+            send_frame(fd, line);
+            if (!receive_frame(fd, response))
+                break;
+            std::cout << response << std::flush;
+        }
+        ::close(fd);
+    } catch (const std::exception& e) {
+        std::cerr << '@' << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
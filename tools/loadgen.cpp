@@ -0,0 +1,99 @@
+#include "../lib/CoolDB/Server/Protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// cooldb_loadgen ADDRESS [-c connections] [-n requests per connection] [-f file] [statement...]
+// Every connection sends the statements of the file and of the command line in turn, one at a time,
+// and times each answer. Prints the throughput and latency percentiles of all of them
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+    if (argc < 2) {
+        std::cerr << "usage: cooldb_loadgen unix:<path>|tcp:<port> [-c connections] [-n requests] "
+                     "[-f file] [statement...]\n";
+        return 1;
+    }
+    const std::string address = argv[1];
+    size_t connections = 8;
+    size_t requests = 1000;
+    std::vector<std::string> statements;
+    for (int i = 2; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-c") && i + 1 < argc) {
+            connections = std::max(1ul, std::stoul(argv[++i]));
+        } else if (!std::strcmp(argv[i], "-n") && i + 1 < argc) {
+            requests = std::stoul(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-f") && i + 1 < argc) {
+            std::ifstream file(argv[++i]);
+            if (!file.is_open()) {
+                std::cerr << "@Can't open " << argv[i] << '\n';
+                return 1;
+            }
+            for (std::string line; std::getline(file, line);)
+                if (!line.empty())
+                    statements.push_back(line);
+        } else {
+            statements.emplace_back(argv[i]);
+        }
+    }
+    if (statements.empty()) {
+        std::cerr << "@No statements to send\n";
+        return 1;
+    }
+
+    // latencies in microseconds, each connection fills its own
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<std::string> errors(connections);
+    std::vector<std::thread> threads;
+    const auto start = clock::now();
+    for (size_t c = 0; c < connections; ++c) {
+        threads.emplace_back([&, c] {
+            try {
+                const int fd = connect_to(address);
+                std::string response;
+                latencies[c].reserve(requests);
+                // the connections start at different statements of the list
+                for (size_t k = 0; k < requests; ++k) {
+                    const auto sent = clock::now();
+                    send_frame(fd, statements[(c + k) % statements.size()]);
+                    if (!receive_frame(fd, response))
+                        throw std::runtime_error{"Connection closed by the server"};
+                    latencies[c].push_back(std::chrono::duration<double, std::micro>(clock::now() - sent).count());
+                }
+                ::close(fd);
+            } catch (const std::exception& e) {
+                errors[c] = e.what();
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    for (const std::string& error : errors) {
+        if (!error.empty()) {
+            std::cerr << '@' << error << '\n';
+            return 1;
+        }
+    }
+    std::vector<double> all;
+    for (const std::vector<double>& part : latencies)
+        all.insert(all.end(), part.begin(), part.end());
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) {
+        return all.empty() ? 0.0 : all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+    };
+    std::cout << std::fixed << std::setprecision(1)
+              << "requests: " << all.size() << ", connections: " << connections
+              << ", time: " << seconds << " s, qps: " << all.size() / seconds << '\n'
+              << "latency us: p50 " << percentile(0.50) << ", p99 " << percentile(0.99)
+              << ", max " << (all.empty() ? 0.0 : all.back()) << '\n';
+    return 0;
+}